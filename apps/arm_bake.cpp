@@ -0,0 +1,139 @@
+//* Author: Zac Zhuo Zhang
+//* Headless trajectory baking: mesh every frame of a keyframed Rad0/Rad1 animation on all cores and write
+//* one file with a single index buffer and per-frame vertex positions (see ArmTrajectory.h).
+//*
+//* Usage:
+//*   arm_bake keyframes.txt out.armtraj [--fps F] [--frames N] [--delta] [--threads N] [--set NAME=VALUE]...
+//*
+//* A keyframe file holds "time Rad0 Rad1" per line (comma or space separated, '#' starts a comment), time
+//* in seconds and increasing. Without --frames, the whole trajectory is baked at --fps (default 30).
+//* Parameters other than Rad0/Rad1 come from --set or keep the viewer defaults.
+//* The viewer plays a baked file back with: arm out.armtraj
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "ArmTrajectory.h"
+#include "WorkStealingPool.h"
+
+static bool readKeyframes(const std::string &path, std::vector<ArmKeyframe> &keyframes)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        for (char &c : line)
+            if (c == ',' || c == ';' || c == '\t')
+                c = ' ';
+
+        std::istringstream values(line);
+        ArmKeyframe key;
+        if (!(values >> key.time))
+            continue;
+        if (!(values >> key.Rad0 >> key.Rad1) || (!keyframes.empty() && key.time <= keyframes.back().time))
+        {
+            std::cerr << "Expected increasing \"time Rad0 Rad1\" lines in " << path << ": " << line << std::endl;
+            return false;
+        }
+        keyframes.push_back(key);
+    }
+    return !keyframes.empty();
+}
+
+static void printUsage()
+{
+    std::cerr << "Usage: arm_bake keyframes.txt out.armtraj [--fps F] [--frames N] [--delta] [--threads N] [--set NAME=VALUE]...\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    ArmTrajectory trajectory;
+    std::string outPath = argv[2];
+    double fps = 30;
+    int frames = 0;
+    bool delta = false;
+    unsigned threads = 0;
+
+    for (int i = 3; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--fps" && hasValue)
+            fps = std::atof(argv[++i]);
+        else if (arg == "--frames" && hasValue)
+            frames = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)
+            threads = (unsigned)std::atoi(argv[++i]);
+        else if (arg == "--delta")
+            delta = true;
+        else if (arg == "--set" && hasValue)
+        {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            int parameter = -1;
+            for (int k = 0; k < ArmParameters::Count && eq != std::string::npos; k++)
+                if (spec.compare(0, eq, ArmParameters::name(k)) == 0)
+                    parameter = k;
+            if (parameter < 0)
+            {
+                printUsage();
+                return 1;
+            }
+            trajectory.base[parameter] = std::atof(spec.c_str() + eq + 1);
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (!readKeyframes(argv[1], trajectory.keyframes))
+    {
+        std::cerr << "Cannot read keyframes: " << argv[1] << std::endl;
+        return 1;
+    }
+    if (!(fps > 0))
+    {
+        printUsage();
+        return 1;
+    }
+    if (!ArmParameters::validMeshMaxDistance(trajectory.base.MeshMaxDistance))
+    {
+        std::cerr << "MeshMaxDistance must be positive and finite" << std::endl;
+        return 1;
+    }
+    if (frames <= 0)
+        frames = (int)std::floor(trajectory.duration() * fps + 1e-9) + 1;
+
+    WorkStealingPool pool(threads);
+    ArmTrajectoryBaker baker(&pool);
+
+    auto start = std::chrono::steady_clock::now();
+    bool written = baker.bake(trajectory, frames, fps, outPath, delta);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const ArmMeshLayout &layout = baker.layout();
+    std::cerr << frames << " frames of " << layout.vertices << " vertices, " << layout.faces << " faces on " << pool.threadCount() << " threads in "
+              << seconds << " s (" << (seconds > 0 ? frames / seconds : 0) << " frames/s)" << std::endl;
+    if (!written)
+    {
+        std::cerr << "Cannot write " << outPath << ", or a frame has non-finite vertices" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,426 @@
+//* Author: Zac Zhuo Zhang
+//* Headless parameter sweep: generate the arm mesh for a grid or a list of parameter tuples on all cores.
+//*
+//* Usage:
+//*   arm_sweep [--threads N] [--out results.csv]
+//*             [--set NAME=VALUE]... [--grid NAME=MIN:MAX:COUNT]...
+//*   arm_sweep [--threads N] [--out results.csv] --list tuples.csv
+//*   add --profile-csv timings.csv to write the per-stage timings of every build (needs ARM_PROFILING)
+//*   add --cache-mb MB [--cache-tolerance T] to reuse the meshes of repeated tuples (LRU, quantized to T)
+//*   add --export DIR [--format ply|stl] to stream every variant to DIR/arm_<index>.<format> (binary)
+//*   add --screen to only evaluate the analytic validity (ArmValidity.h) instead of meshing: the CSV gets
+//*   the validity flags and the clearance instead of the mesh size
+//*   arm_sweep [--threads N] [--set NAME=VALUE]... --workspace-map map.csv [--map-size N]
+//*   samples an N x N Rad0/Rad1 grid (default 256) over the viewer's slider range and writes its validity
+//*
+//* NAME is one of R0, R1, R2, Rad0, Rad1, length0, length1, d, MeshMaxDistance, thickness.
+//* A list file holds one tuple of the ten values per line (comma or space separated, '#' starts a comment).
+//* Parameters that are neither set nor swept keep the viewer defaults.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ArmMeshBuilder.h"
+#include "WorkStealingPool.h"
+#include "ArmProfiler.h"
+#include "ArmMeshCache.h"
+#include "ArmMeshWriters.h"
+#include "ArmValidity.h"
+
+struct GridAxis
+{
+    int parameter;
+    double min;
+    double max;
+    int count;
+};
+
+//* Either an explicit list of tuples or the cartesian product of the grid axes over a base tuple.
+class ParameterSweep
+{
+public:
+    ArmParameters base;
+    std::vector<GridAxis> axes;
+    std::vector<ArmParameters> list;
+
+    //* Saturates past INT_MAX, the largest sweep the pool can index.
+    long long size() const
+    {
+        if (!list.empty())
+            return (long long)list.size();
+        long long n = 1;
+        for (const GridAxis &axis : axes)
+            n = std::min(n * axis.count, (long long)INT_MAX + 1);
+        return n;
+    }
+
+    ArmParameters at(long long index) const
+    {
+        if (!list.empty())
+            return list[index];
+
+        ArmParameters p = base;
+        for (const GridAxis &axis : axes)
+        {
+            int i = (int)(index % axis.count);
+            index /= axis.count;
+            p[axis.parameter] = axis.count == 1 ? axis.min : axis.min + (axis.max - axis.min) * i / (axis.count - 1);
+        }
+        return p;
+    }
+};
+
+struct SweepResult
+{
+    int vertices = 0;
+    int faces = 0;
+    bool finite = false;
+    unsigned flags = 0;  // --screen
+    double clearance = 0; // --screen
+};
+
+//* Forwards to a writer and notes whether every vertex was finite.
+class FiniteCheckingSink : public ArmMeshSink
+{
+public:
+    explicit FiniteCheckingSink(ArmMeshSink &target) : target(target) {}
+
+    bool finite = true;
+
+    void begin(int vertices, int faces) override { target.begin(vertices, faces); }
+    void vertex(double x, double y, double z) override
+    {
+        finite = finite && std::isfinite(x) && std::isfinite(y) && std::isfinite(z);
+        target.vertex(x, y, z);
+    }
+    void face(int a, int b, int c, const Eigen::Vector3d &pa, const Eigen::Vector3d &pb, const Eigen::Vector3d &pc) override { target.face(a, b, c, pa, pb, pc); }
+    bool end() override { return target.end(); }
+
+private:
+    ArmMeshSink &target;
+};
+
+enum class ExportFormat
+{
+    Ply,
+    Stl
+};
+
+//* The one writer an export task needs.
+static std::unique_ptr<ArmMeshSink> makeMeshWriter(ExportFormat format, const std::string &path)
+{
+    if (format == ExportFormat::Stl)
+        return std::unique_ptr<ArmMeshSink>(new StlMeshWriter(path));
+    return std::unique_ptr<ArmMeshSink>(new PlyMeshWriter(path));
+}
+
+static int parameterIndex(const std::string &name)
+{
+    for (int i = 0; i < ArmParameters::Count; i++)
+        if (name == ArmParameters::name(i))
+            return i;
+    std::cerr << "Unknown parameter: " << name << std::endl;
+    std::exit(1);
+}
+
+static bool readList(const std::string &path, std::vector<ArmParameters> &list)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        for (char &c : line)
+            if (c == ',' || c == ';' || c == '\t')
+                c = ' ';
+
+        std::istringstream values(line);
+        ArmParameters p;
+        int n = 0;
+        while (n < ArmParameters::Count && values >> p[n])
+            n++;
+        if (n == 0)
+            continue;
+        if (n != ArmParameters::Count)
+        {
+            std::cerr << "Expected " << ArmParameters::Count << " values per line in " << path << ": " << line << std::endl;
+            return false;
+        }
+        list.push_back(p);
+    }
+    return true;
+}
+
+static void printUsage()
+{
+    std::cerr << "Usage: arm_sweep [--threads N] [--out results.csv] [--set NAME=VALUE]... [--grid NAME=MIN:MAX:COUNT]...\n"
+                 "       arm_sweep [--threads N] [--out results.csv] --list tuples.csv\n"
+                 "       [--profile-csv timings.csv] [--cache-mb MB] [--cache-tolerance T] [--export DIR [--format ply|stl]] [--screen]\n"
+                 "       arm_sweep [--threads N] [--set NAME=VALUE]... --workspace-map map.csv [--map-size N]\n";
+}
+
+int main(int argc, char *argv[])
+{
+    ParameterSweep sweep;
+    unsigned threads = 0;
+    std::string outPath;
+    std::string profilePath;
+    double cacheMegabytes = 0;
+    double cacheTolerance = 1e-9;
+    std::string exportDirectory;
+    std::string exportFormat = "ply";
+    bool screen = false;
+    std::string mapPath;
+    int mapSize = 256;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue)
+            threads = (unsigned)std::atoi(argv[++i]);
+        else if (arg == "--out" && hasValue)
+            outPath = argv[++i];
+        else if (arg == "--profile-csv" && hasValue)
+            profilePath = argv[++i];
+        else if (arg == "--cache-mb" && hasValue)
+            cacheMegabytes = std::atof(argv[++i]);
+        else if (arg == "--cache-tolerance" && hasValue)
+            cacheTolerance = std::atof(argv[++i]);
+        else if (arg == "--export" && hasValue)
+            exportDirectory = argv[++i];
+        else if (arg == "--format" && hasValue && (std::strcmp(argv[i + 1], "ply") == 0 || std::strcmp(argv[i + 1], "stl") == 0))
+            exportFormat = argv[++i];
+        else if (arg == "--screen")
+            screen = true;
+        else if (arg == "--workspace-map" && hasValue)
+            mapPath = argv[++i];
+        else if (arg == "--map-size" && hasValue)
+            mapSize = std::atoi(argv[++i]);
+        else if (arg == "--list" && hasValue)
+        {
+            if (!readList(argv[++i], sweep.list))
+            {
+                std::cerr << "Cannot read tuple list: " << argv[i] << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--set" && hasValue)
+        {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            if (eq == std::string::npos)
+            {
+                printUsage();
+                return 1;
+            }
+            sweep.base[parameterIndex(spec.substr(0, eq))] = std::atof(spec.c_str() + eq + 1);
+        }
+        else if (arg == "--grid" && hasValue)
+        {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            GridAxis axis;
+            if (eq == std::string::npos || std::sscanf(spec.c_str() + eq + 1, "%lf:%lf:%d", &axis.min, &axis.max, &axis.count) != 3 || axis.count < 1)
+            {
+                printUsage();
+                return 1;
+            }
+            axis.parameter = parameterIndex(spec.substr(0, eq));
+            sweep.axes.push_back(axis);
+        }
+        else
+        {
+            printUsage();
+            return 1;
+        }
+    }
+
+    bool validResolution = ArmParameters::validMeshMaxDistance(sweep.base.MeshMaxDistance);
+    for (const GridAxis &axis : sweep.axes)
+        if (axis.parameter == ArmParameters::MeshMaxDistanceIndex)
+            validResolution = validResolution && ArmParameters::validMeshMaxDistance(axis.min) && ArmParameters::validMeshMaxDistance(axis.max);
+    for (const ArmParameters &p : sweep.list)
+        validResolution = validResolution && ArmParameters::validMeshMaxDistance(p.MeshMaxDistance);
+    if (!validResolution)
+    {
+        std::cerr << "MeshMaxDistance must be positive and finite" << std::endl;
+        return 1;
+    }
+
+    if (sweep.size() > INT_MAX)
+    {
+        std::cerr << "Too many variants: a sweep has at most " << INT_MAX << std::endl;
+        return 1;
+    }
+
+#ifndef ARM_PROFILING
+    if (!profilePath.empty())
+    {
+        std::cerr << "--profile-csv needs a build with ARM_PROFILING" << std::endl;
+        return 1;
+    }
+#endif
+    if (!profilePath.empty())
+        ArmProfiler::instance().setCapture(true);
+
+    WorkStealingPool pool(threads);
+    if (!mapPath.empty())
+    {
+        //* The map has mapSize^2 cells, indexed by int.
+        if (mapSize < 1 || (long long)mapSize * mapSize > INT_MAX)
+        {
+            std::cerr << "--map-size must be between 1 and 46340" << std::endl;
+            return 1;
+        }
+        ArmWorkspaceMap map(&pool);
+        auto start = std::chrono::steady_clock::now();
+        map.sample(sweep.base, mapSize, mapSize);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << mapSize << " x " << mapSize << " workspace map on " << pool.threadCount() << " threads in " << seconds << " s, "
+                  << map.validCount() << " valid" << std::endl;
+        if (!map.writeCsv(mapPath))
+        {
+            std::cerr << "Cannot write: " << mapPath << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    long long count = sweep.size();
+    std::vector<SweepResult> results(count);
+
+    //* One builder and one V/F per thread (plus the calling thread), reused across variants.
+    struct Workspace
+    {
+        ArmMeshBuilder builder;
+        Eigen::MatrixXd V;
+        Eigen::MatrixXi F;
+        ArmValidityEvaluator evaluator;
+    };
+    std::vector<Workspace> workspaces(pool.threadCount() + 1);
+    if (!exportDirectory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(exportDirectory, error);
+        if (error)
+        {
+            std::cerr << "Cannot create: " << exportDirectory << std::endl;
+            return 1;
+        }
+    }
+    std::atomic<long long> exportFailures{0};
+
+    std::unique_ptr<ArmMeshCache> cache;
+    if (cacheMegabytes > 0)
+        cache.reset(new ArmMeshCache((size_t)(cacheMegabytes * 1048576), cacheTolerance));
+
+    const ExportFormat format = exportFormat == "stl" ? ExportFormat::Stl : ExportFormat::Ply;
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(0, (int)count, 16, [&](int i)
+                     {
+        Workspace &w = workspaces[pool.currentThreadIndex()];
+        if (screen)
+        {
+            ArmValidity validity = w.evaluator.evaluate(sweep.at(i));
+            results[i].flags = validity.flags;
+            results[i].clearance = validity.clearance;
+            results[i].finite = validity.valid();
+            return;
+        }
+        if (!exportDirectory.empty())
+        {
+            //* Straight from the builder to the file, no V/F.
+            char name[32];
+            std::snprintf(name, sizeof(name), "arm_%06d.", i);
+            std::string path = exportDirectory + "/" + name + exportFormat;
+            std::unique_ptr<ArmMeshSink> writer = makeMeshWriter(format, path);
+            FiniteCheckingSink sink(*writer);
+            if (!w.builder.stream(sweep.at(i), sink))
+                exportFailures++;
+            results[i].vertices = w.builder.layout().vertices;
+            results[i].faces = w.builder.layout().faces;
+            results[i].finite = sink.finite;
+            return;
+        }
+        if (cache)
+        {
+            //* Variants that only differ in thickness share one profile.
+            std::shared_ptr<const ArmProfile> profile = cache->findOrBuild(sweep.at(i), w.builder);
+            results[i].vertices = profile->vertices();
+            results[i].faces = profile->faces();
+            results[i].finite = profile->finite();
+            return;
+        }
+        w.builder.build(sweep.at(i), w.V, w.F);
+        results[i].vertices = (int)w.V.rows();
+        results[i].faces = (int)w.F.rows();
+        results[i].finite = w.V.allFinite(); });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long invalid = 0;
+    for (const SweepResult &result : results)
+        invalid += !result.finite;
+
+    std::cerr << count << " variants on " << pool.threadCount() << " threads in " << seconds << " s ("
+              << (seconds > 0 ? count / seconds : 0) << " variants/s), " << invalid << (screen ? " invalid" : " with non-finite vertices") << std::endl;
+    if (exportFailures > 0)
+        std::cerr << exportFailures << " exports failed" << std::endl;
+    if (cache)
+    {
+        ArmMeshCache::Statistics statistics = cache->statistics();
+        std::cerr << "mesh cache: " << statistics.hits << " hits, " << statistics.misses << " misses, " << statistics.evictions << " evictions, "
+                  << statistics.entries << " entries, " << statistics.bytes / 1048576.0 << " MB" << std::endl;
+    }
+
+    if (!outPath.empty())
+    {
+        std::ofstream out(outPath);
+        if (!out)
+        {
+            std::cerr << "Cannot write: " << outPath << std::endl;
+            return 1;
+        }
+        out.precision(17);
+        out << "index";
+        for (int k = 0; k < ArmParameters::Count; k++)
+            out << ',' << ArmParameters::name(k);
+        out << (screen ? ",flags,clearance\n" : ",vertices,faces,finite\n");
+        for (long long i = 0; i < count; i++)
+        {
+            ArmParameters p = sweep.at(i);
+            out << i;
+            for (int k = 0; k < ArmParameters::Count; k++)
+                out << ',' << p[k];
+            if (screen)
+                out << ',' << results[i].flags << ',' << results[i].clearance << '\n';
+            else
+                out << ',' << results[i].vertices << ',' << results[i].faces << ',' << results[i].finite << '\n';
+        }
+    }
+
+    if (!profilePath.empty() && !ArmProfiler::instance().writeCsv(profilePath))
+    {
+        std::cerr << "Cannot write: " << profilePath << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,455 @@
+//* Author: Zac Zhuo Zhang
+//* Micro benchmarks of the geometry kernels and macro benchmarks of the full mesh build
+//* (ArmMeshGeneration, ArmMeshBuilder reusing its buffers, and incremental ArmModel updates).
+//* MeshMaxDistance is swept from 0.1 down to 1e-4 for the resolution dependent benchmarks.
+//*
+//* Usage:
+//*   arm_bench [--filter TEXT] [--min-time SECONDS] [--json results.json]
+//*
+//* Reports ns/op, vertices/s, triangles/s and heap allocations per call.
+//* The JSON output is stable (one benchmark per line) so two runs can be diffed directly.
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ArmMeshGeneration.h"
+#include "ArmModel.h"
+#include "ArmChainBuilder.h"
+#include "ArmInverseKinematics.h"
+
+//* HEAP ALLOCATION COUNTER----------------------------------------------------------------------------------------------------------------------------------------------------------------
+//* Eigen allocates with std::malloc, not operator new, so malloc itself is interposed (glibc only).
+
+static std::atomic<long long> allocationCount(0);
+
+#if defined(__GLIBC__)
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *pointer, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+
+    void *malloc(size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *pointer, size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(pointer, size);
+    }
+
+    int posix_memalign(void **pointer, size_t alignment, size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        *pointer = __libc_memalign(alignment, size);
+        return *pointer ? 0 : ENOMEM;
+    }
+}
+static const bool allocationCountSupported = true;
+#else
+static const bool allocationCountSupported = false;
+#endif
+
+//* HARNESS----------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+struct BenchmarkResult
+{
+    std::string name;
+    double meshMaxDistance = 0;
+    long long iterations = 0;
+    double nsPerOp = 0;
+    double allocationsPerOp = 0;
+    long long vertices = 0;  // per call, 0 when not applicable
+    long long triangles = 0; // per call, 0 when not applicable
+    long long items = 1;     // configurations solved per call (batch kernels)
+};
+
+static volatile double sink;
+
+class BenchmarkRunner
+{
+public:
+    std::string filter;
+    double minTime = 0.2;
+    std::vector<BenchmarkResult> results;
+
+    //* Run body() until a batch takes at least minTime, doubling the batch size.
+    //* body returns a value that is accumulated into a volatile so the work cannot be optimized away.
+    template <typename Body>
+    void run(const std::string &name, double meshMaxDistance, long long vertices, long long triangles, Body body, long long items = 1)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos)
+            return;
+
+        body(); // warm up
+
+        long long iterations = 1;
+        while (true)
+        {
+            double checksum = 0;
+            long long allocationsBefore = allocationCount.load();
+            auto start = std::chrono::steady_clock::now();
+            for (long long i = 0; i < iterations; i++)
+                checksum += body();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            long long allocations = allocationCount.load() - allocationsBefore;
+            sink = checksum;
+
+            if (seconds >= minTime || iterations >= (1LL << 40))
+            {
+                BenchmarkResult result;
+                result.name = name;
+                result.meshMaxDistance = meshMaxDistance;
+                result.iterations = iterations;
+                result.nsPerOp = seconds * 1e9 / iterations;
+                result.allocationsPerOp = allocationCountSupported ? (double)allocations / iterations : -1;
+                result.vertices = vertices;
+                result.triangles = triangles;
+                result.items = items;
+                results.push_back(result);
+                print(result);
+                return;
+            }
+            iterations *= 2;
+        }
+    }
+
+    static void print(const BenchmarkResult &r)
+    {
+        std::printf("%-64s %10.4g %14.1f ns/op %8.1f allocs/op", r.name.c_str(), r.meshMaxDistance, r.nsPerOp, r.allocationsPerOp);
+        if (r.vertices > 0)
+            std::printf(" %12.4g vertices/s %12.4g triangles/s", r.vertices * 1e9 / r.nsPerOp, r.triangles * 1e9 / r.nsPerOp);
+        if (r.items > 1)
+            std::printf(" %10.2f ns/item", r.nsPerOp / r.items);
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    bool writeJson(const std::string &path) const
+    {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        out.precision(9);
+        out << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const BenchmarkResult &r = results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"mesh_max_distance\": " << r.meshMaxDistance
+                << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.nsPerOp
+                << ", \"allocations_per_op\": " << r.allocationsPerOp
+                << ", \"items\": " << r.items << ", \"ns_per_item\": " << r.nsPerOp / r.items
+                << ", \"vertices\": " << r.vertices << ", \"triangles\": " << r.triangles
+                << ", \"vertices_per_second\": " << (r.vertices > 0 ? r.vertices * 1e9 / r.nsPerOp : 0)
+                << ", \"triangles_per_second\": " << (r.triangles > 0 ? r.triangles * 1e9 / r.nsPerOp : 0) << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+        return true;
+    }
+};
+
+//* BENCHMARKS----------------------------------------------------------------------------------------------------------------------------------------------------------------
+
+static const double meshMaxDistances[] = {0.1, 0.03, 0.01, 0.003, 0.001, 0.0003, 0.0001};
+
+int main(int argc, char *argv[])
+{
+    BenchmarkRunner runner;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+            runner.filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc)
+            runner.minTime = std::atof(argv[++i]);
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+        {
+            std::cerr << "Usage: arm_bench [--filter TEXT] [--min-time SECONDS] [--json results.json]\n";
+            return 1;
+        }
+    }
+
+    //* The default arm of the viewer, with the elbow bent so the fillet exists.
+    ArmParameters p;
+    p.Rad0 = 0.5;
+    p.Rad1 = 0.7;
+
+    TangentLinesCalculator2D tangentLinesCalculator;
+    TangentCircleCalculator2D tangentCircleCalculator;
+    CircleArcDivider2D circleArcDivider;
+
+    Eigen::Vector2d P0(0, 0);
+    Eigen::Vector2d P1(p.length0 * std::cos(p.Rad0), p.length0 * std::sin(p.Rad0));
+    Eigen::Vector2d P2 = P1 + Eigen::Vector2d(std::cos(-p.Rad1) * p.length1, std::sin(-p.Rad1) * p.length1);
+    TangentLinesCalculator2D::Points tan0Points = tangentLinesCalculator.getTangentLines0(P0, p.R0, P1, p.R1);
+    TangentLinesCalculator2D::Points tan1Points = tangentLinesCalculator.getTangentLines0(P1, p.R1, P2, p.R2);
+
+    runner.run("TangentLinesCalculator2D::getTangentLines0", 0, 0, 0, [&]
+               { return tangentLinesCalculator.getTangentLines0(P0, p.R0, P1, p.R1)(0, 0); });
+
+    runner.run("TangentLinesCalculator2D::getTangentLines1", 0, 0, 0, [&]
+               { return tangentLinesCalculator.getTangentLines1(P0, p.R0, P1, p.R1)(0, 0); });
+
+    runner.run("TangentCircleCalculator2D::getTangentCircleCenter", 0, 0, 0, [&]
+               {
+                   TangentCircleCalculator2D::Points tanPoints;
+                   return tangentCircleCalculator.getTangentCircleCenter(tan0Points.row(2), tan0Points.row(3), tan1Points.row(3), tan1Points.row(2), p.d, tanPoints).second; });
+
+    //* Batched structure-of-arrays solves over jittered copies of the arm.
+    const int batchSize = 4096;
+    std::vector<double> soa[16];
+    for (std::vector<double> &column : soa)
+        column.resize(batchSize);
+    for (int i = 0; i < batchSize; i++)
+    {
+        double jitter = 1e-3 * (i % 97);
+        soa[0][i] = P0.x() + jitter, soa[1][i] = P0.y(), soa[2][i] = p.R0;
+        soa[3][i] = P1.x(), soa[4][i] = P1.y() + jitter, soa[5][i] = p.R1;
+    }
+    CirclePairsSoA circlePairs = {soa[0].data(), soa[1].data(), soa[2].data(), soa[3].data(), soa[4].data(), soa[5].data(), batchSize};
+    TangentPointsSoA tangentPoints = {{soa[6].data(), soa[7].data(), soa[8].data(), soa[9].data()}, {soa[10].data(), soa[11].data(), soa[12].data(), soa[13].data()}};
+
+    runner.run("TangentLinesCalculator2D::getTangentLines0Batch/4096", 0, 0, 0, [&]
+               {
+                   tangentLinesCalculator.getTangentLines0Batch(circlePairs, tangentPoints);
+                   return soa[6][0]; }, batchSize);
+
+    runner.run("TangentLinesCalculator2D::getTangentLines1Batch/4096", 0, 0, 0, [&]
+               {
+                   tangentLinesCalculator.getTangentLines1Batch(circlePairs, tangentPoints);
+                   return soa[6][0]; }, batchSize);
+
+    //* The same batch in float: twice the configurations per vector, half the bytes.
+    std::vector<float> soaFloat[16];
+    for (int k = 0; k < 16; k++)
+        soaFloat[k].assign(soa[k].begin(), soa[k].end());
+    TangentLinesCalculator2Df tangentLinesCalculatorFloat;
+    CirclePairsSoAf circlePairsFloat = {soaFloat[0].data(), soaFloat[1].data(), soaFloat[2].data(), soaFloat[3].data(), soaFloat[4].data(), soaFloat[5].data(), batchSize};
+    TangentPointsSoAf tangentPointsFloat = {{soaFloat[6].data(), soaFloat[7].data(), soaFloat[8].data(), soaFloat[9].data()}, {soaFloat[10].data(), soaFloat[11].data(), soaFloat[12].data(), soaFloat[13].data()}};
+
+    runner.run("TangentLinesCalculator2Df::getTangentLines0Batch/4096", 0, 0, 0, [&]
+               {
+                   tangentLinesCalculatorFloat.getTangentLines0Batch(circlePairsFloat, tangentPointsFloat);
+                   return soaFloat[6][0]; }, batchSize);
+
+    //* Lines of the two links, laid out as the builder passes them.
+    std::vector<double> lineSoa[16];
+    for (std::vector<double> &column : lineSoa)
+        column.resize(batchSize);
+    for (int i = 0; i < batchSize; i++)
+    {
+        double jitter = 1e-4 * (i % 89);
+        lineSoa[0][i] = tan0Points(2, 0), lineSoa[1][i] = tan0Points(2, 1) + jitter;
+        lineSoa[2][i] = tan0Points(3, 0), lineSoa[3][i] = tan0Points(3, 1);
+        lineSoa[4][i] = tan1Points(3, 0), lineSoa[5][i] = tan1Points(3, 1);
+        lineSoa[6][i] = tan1Points(2, 0), lineSoa[7][i] = tan1Points(2, 1) + jitter;
+        lineSoa[8][i] = p.d;
+    }
+    LinePairsSoA linePairs = {lineSoa[0].data(), lineSoa[1].data(), lineSoa[2].data(), lineSoa[3].data(), lineSoa[4].data(), lineSoa[5].data(), lineSoa[6].data(), lineSoa[7].data(), lineSoa[8].data(), batchSize};
+    TangentCirclesSoA tangentCircles = {lineSoa[9].data(), lineSoa[10].data(), lineSoa[11].data(), lineSoa[12].data(), lineSoa[13].data(), lineSoa[14].data(), lineSoa[15].data()};
+
+    runner.run("TangentCircleCalculator2D::getTangentCircleCenterBatch/4096", 0, 0, 0, [&]
+               {
+                   tangentCircleCalculator.getTangentCircleCenterBatch(linePairs, tangentCircles);
+                   return lineSoa[9][0]; }, batchSize);
+
+    std::vector<float> lineSoaFloat[16];
+    for (int k = 0; k < 16; k++)
+        lineSoaFloat[k].assign(lineSoa[k].begin(), lineSoa[k].end());
+    TangentCircleCalculator2Df tangentCircleCalculatorFloat;
+    LinePairsSoAf linePairsFloat = {lineSoaFloat[0].data(), lineSoaFloat[1].data(), lineSoaFloat[2].data(), lineSoaFloat[3].data(), lineSoaFloat[4].data(), lineSoaFloat[5].data(), lineSoaFloat[6].data(), lineSoaFloat[7].data(), lineSoaFloat[8].data(), batchSize};
+    TangentCirclesSoAf tangentCirclesFloat = {lineSoaFloat[9].data(), lineSoaFloat[10].data(), lineSoaFloat[11].data(), lineSoaFloat[12].data(), lineSoaFloat[13].data(), lineSoaFloat[14].data(), lineSoaFloat[15].data()};
+
+    runner.run("TangentCircleCalculator2Df::getTangentCircleCenterBatch/4096", 0, 0, 0, [&]
+               {
+                   tangentCircleCalculatorFloat.getTangentCircleCenterBatch(linePairsFloat, tangentCirclesFloat);
+                   return lineSoaFloat[9][0]; }, batchSize);
+
+    //* Arc 0 of the arm: the half circle around P0.
+    Eigen::Vector2d arcA = tan0Points.row(0), arcB = tan0Points.row(2);
+    Eigen::MatrixXd arcPoints;
+    for (double distance : meshMaxDistances)
+    {
+        arcPoints.resize(circleArcDivider.countArcPoints(P0, p.R0, arcA, arcB, distance), 3);
+        runner.run("CircleArcDivider2D::divideArc2D", distance, arcPoints.rows(), 0, [&]
+                   {
+                       circleArcDivider.divideArc2D(P0, p.R0, arcA, arcB, distance, arcPoints);
+                       return arcPoints(0, 0); });
+    }
+
+    CircleArcDivider2D recurrenceDivider(ArcTessellation::Recurrence);
+    for (double distance : meshMaxDistances)
+    {
+        arcPoints.resize(recurrenceDivider.countArcPoints(P0, p.R0, arcA, arcB, distance), 3);
+        runner.run("CircleArcDivider2D::divideArc2D/recurrence", distance, arcPoints.rows(), 0, [&]
+                   {
+                       recurrenceDivider.divideArc2D(P0, p.R0, arcA, arcB, distance, arcPoints);
+                       return arcPoints(0, 0); });
+    }
+
+    for (double distance : meshMaxDistances)
+    {
+        ArmParameters q = p;
+        q.MeshMaxDistance = distance;
+        std::pair<Eigen::MatrixXd, Eigen::MatrixXi> VF = ArmMeshGeneration(q);
+        runner.run("ArmMeshGeneration", distance, VF.first.rows(), VF.second.rows(), [&]
+                   { return ArmMeshGeneration(q).first(0, 0); });
+    }
+
+    //* Same mesh through a reused builder and reused buffers.
+    ArmMeshBuilder builder;
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi F;
+    for (double distance : meshMaxDistances)
+    {
+        ArmParameters q = p;
+        q.MeshMaxDistance = distance;
+        builder.build(q, V, F);
+        runner.run("ArmMeshBuilder::build", distance, V.rows(), F.rows(), [&]
+                   {
+                       builder.build(q, V, F);
+                       return V(0, 0); });
+    }
+
+    //* Solved in double, written as float (what an upload needs), and solved in float as well.
+    Eigen::MatrixXf floatV;
+    for (double distance : meshMaxDistances)
+    {
+        ArmParameters q = p;
+        q.MeshMaxDistance = distance;
+        builder.build(q, floatV, F);
+        runner.run("ArmMeshBuilder::build/float output", distance, floatV.rows(), F.rows(), [&]
+                   {
+                       builder.build(q, floatV, F);
+                       return floatV(0, 0); });
+    }
+
+    ArmMeshBuilderf floatBuilder;
+    for (double distance : meshMaxDistances)
+    {
+        ArmParameters q = p;
+        q.MeshMaxDistance = distance;
+        floatBuilder.build(q, floatV, F);
+        runner.run("ArmMeshBuilderf::build", distance, floatV.rows(), F.rows(), [&]
+                   {
+                       floatBuilder.build(q, floatV, F);
+                       return floatV(0, 0); });
+    }
+
+    //* With analytic normals and split side vertices.
+    ArmMeshBuilder normalBuilder(true);
+    Eigen::MatrixXd N;
+    for (double distance : meshMaxDistances)
+    {
+        ArmParameters q = p;
+        q.MeshMaxDistance = distance;
+        normalBuilder.build(q, V, F, N);
+        runner.run("ArmMeshBuilder::build/normals", distance, V.rows(), F.rows(), [&]
+                   {
+                       normalBuilder.build(q, V, F, N);
+                       return N(0, 0); });
+    }
+
+    //* Incremental updates of a fine mesh: thickness only moves back z, R2 leaves link 0 and arc0 alone.
+    {
+        ArmParameters q = p;
+        q.MeshMaxDistance = 0.001;
+        ArmModel model(q);
+        model.update();
+        long long vertices = model.V().rows(), triangles = model.F().rows();
+        int toggle = 0;
+        runner.run("ArmModel::update/thickness", q.MeshMaxDistance, vertices, triangles, [&]
+                   {
+                       model.set(9, (toggle++ & 1) ? 0.5 : 0.6);
+                       model.update();
+                       return model.V()(0, 2); });
+        runner.run("ArmModel::update/R2", q.MeshMaxDistance, vertices, triangles, [&]
+                   {
+                       model.set(2, (toggle++ & 1) ? 0.2 : 0.2001);
+                       model.update();
+                       return model.V()(0, 0); });
+    }
+
+    //* Long chains, serial and on all cores.
+    {
+        ArmChainParameters chain;
+        const int links = 1000;
+        chain.radius.assign(links + 1, 0.2);
+        chain.length.assign(links, 1.0);
+        chain.angle.assign(links, 0.25);
+        chain.MeshMaxDistance = 0.01;
+
+        WorkStealingPool pool;
+        ArmChainBuilder serialBuilder, parallelBuilder(&pool);
+        serialBuilder.build(chain, V, F);
+        runner.run("ArmChainBuilder::build/1000 links", chain.MeshMaxDistance, V.rows(), F.rows(), [&]
+                   {
+                       serialBuilder.build(chain, V, F);
+                       return V(0, 0); }, links);
+        runner.run("ArmChainBuilder::build/1000 links/parallel", chain.MeshMaxDistance, V.rows(), F.rows(), [&]
+                   {
+                       parallelBuilder.build(chain, V, F);
+                       return V(0, 0); }, links);
+    }
+
+    //* Inverse kinematics of targets spread over the workspace, serial and on all cores.
+    {
+        const int targetCount = 1 << 20;
+        std::vector<double> targetX(targetCount), targetY(targetCount), rad[4];
+        std::vector<unsigned char> flags[2];
+        for (std::vector<double> &column : rad)
+            column.resize(targetCount);
+        for (std::vector<unsigned char> &column : flags)
+            column.resize(targetCount);
+        for (int i = 0; i < targetCount; i++)
+        {
+            double radius = (p.length0 + p.length1) * ((i % 1009) + 0.5) / 1009;
+            double angle = 2 * M_PI * (i % 997) / 997;
+            targetX[i] = radius * std::cos(angle);
+            targetY[i] = radius * std::sin(angle);
+        }
+        IkTargetsSoA targets = {targetX.data(), targetY.data(), targetCount};
+        IkSolutionsSoA solutions = {{rad[0].data(), rad[1].data()}, {rad[2].data(), rad[3].data()}, {flags[0].data(), flags[1].data()}};
+
+        WorkStealingPool pool;
+        ArmInverseKinematics serialIk, parallelIk(&pool);
+        runner.run("ArmInverseKinematics::solveBatch/1M", 0, 0, 0, [&]
+                   {
+                       serialIk.solveBatch(p, targets, solutions);
+                       return rad[0][0]; }, targetCount);
+        runner.run("ArmInverseKinematics::solveBatch/1M/parallel", 0, 0, 0, [&]
+                   {
+                       parallelIk.solveBatch(p, targets, solutions);
+                       return rad[0][0]; }, targetCount);
+    }
+
+    if (!jsonPath.empty() && !runner.writeJson(jsonPath))
+    {
+        std::cerr << "Cannot write: " << jsonPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
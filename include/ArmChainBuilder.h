@@ -0,0 +1,430 @@
+//* Author: Zac Zhuo Zhang
+//* N-link arm chain P0 -> P1 -> ... -> PN, the generalization of ArmMeshBuilder to any number of links.
+//* Every joint Pj is a circle of radius[j]; consecutive circles are joined by their tangent lines
+//* (TangentLinesCalculator2D::getTangentLines0), the first and last circle are capped by an arc,
+//* every inner joint gets an arc around the joint on the outer side and a fillet arc of distance d on the
+//* inner side (TangentCircleCalculator2D), exactly like the two-link arm at P1.
+//* Joints bend clockwise (angle[j] in (0, pi)), as Rad1 does in the viewer, so the fillet is on the right.
+//*
+//* The mesh is split into one segment per joint: segment j owns the arcs of joint j, their cap fans and
+//* side walls, and link j (joint j -> j + 1) if there is one. Building runs in three passes:
+//*   1. solve the tangents, fillets and arc point counts of every joint (in parallel),
+//*   2. prefix sums give every segment its vertex and face range,
+//*   3. every segment writes its vertices and faces into its own ranges (in parallel).
+//* Links refer to the next joint's vertices by index only, so no segment waits for another.
+//* Cost is linear in the number of links; pass a WorkStealingPool to spread it across cores.
+//* Each profiled stage is its own parallel loop, timed by the calling thread around it: the pool tasks
+//* themselves record nothing, since their totals would stay on the worker threads.
+//*
+//* Vertex layout: front vertices segment by segment ([Pj | outer or cap arc | fillet arc]), then the back
+//* vertices in the same order at z = -thickness. Face layout: segment by segment, [front | back | sides].
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <vector>
+
+#include "ArmParameters.h"
+#include "TangentLinesCalculator.h"
+#include "TangentCircleCalculator.h"
+#include "DivideArc.h"
+#include "WorkStealingPool.h"
+#include "ArmProfiler.h"
+
+struct ArmChainParameters
+{
+    std::vector<double> radius; // N + 1 joint radii
+    std::vector<double> length; // N link lengths
+    std::vector<double> angle;  // N angles: angle[0] direction of link 0 (as Rad0), angle[j] clockwise bend at joint j
+    double d = 0.2;
+    double MeshMaxDistance = 0.05;
+    double thickness = 0.5;
+
+    int links() const { return (int)length.size(); }
+    bool valid() const { return links() >= 1 && (int)radius.size() == links() + 1 && (int)angle.size() == links(); }
+
+    //* The two-link arm as a chain: link 1 points at -Rad1, i.e. it bends by Rad0 + Rad1 at P1.
+    static ArmChainParameters fromArm(const ArmParameters &p);
+};
+
+struct ArmChainLayout
+{
+    int links = 0;
+    int frontVertices = 0;
+    int vertices = 0;
+    int faces = 0;
+};
+
+class ArmChainBuilder
+{
+public:
+    //* Without a pool, everything runs on the calling thread.
+    explicit ArmChainBuilder(WorkStealingPool *pool = nullptr) : pool(pool) {}
+
+    //* Passes 1 and 2: solve every joint and compute the layout, nothing is written yet.
+    const ArmChainLayout &prepare(const ArmChainParameters &p);
+
+    //* prepare(p) followed by writing the whole mesh. Returns false (and empty V, F) for inconsistent parameters.
+    bool build(const ArmChainParameters &p, Eigen::MatrixXd &V, Eigen::MatrixXi &F);
+
+    const ArmChainLayout &layout() const { return chainLayout; }
+
+    //* Joints (or segments) per parallel task.
+    int grain = 64;
+
+private:
+    struct ChainArc
+    {
+        Eigen::Vector2d center, start, end;
+        double radius = 0;
+        int points = 0;
+        int offset = 0; // first front vertex
+    };
+
+    //* Joint j: arcs[0] is the cap arc (first and last joint) or the outer arc, arcs[1] the fillet of an inner joint.
+    struct Joint
+    {
+        Eigen::Vector2d P;
+        ChainArc arcs[2];
+        int arcCount = 1;
+        int vertexOffset = 0;
+        int vertexCount = 0;
+        int faceOffset = 0;
+        int frontFaces = 0;
+        int sideFaces = 0;
+    };
+
+    template <typename Function>
+    void forEach(int count, Function function);
+
+    void solveJoint(int j, const ArmChainParameters &p);
+    void countJoint(int j);
+    void writeSegmentArcs(int j, Eigen::MatrixXd &V) const;
+    void writeSegmentVertices(int j, double thickness, Eigen::MatrixXd &V) const;
+    void writeSegmentFaces(int j, Eigen::MatrixXi &F) const;
+
+    //* Corners of link j: outer and inner side, at joint j (start) and joint j + 1 (end).
+    int outerStart(int link) const;
+    int innerStart(int link) const;
+    int outerEnd(int link) const;
+    int innerEnd(int link) const;
+
+    template <typename Emit>
+    void emitFrontFaces(int j, Emit &&emit) const;
+    template <typename Emit>
+    void emitSideFaces(int j, Emit &&emit) const;
+
+    WorkStealingPool *pool;
+    std::vector<Joint> joints;
+    std::vector<TangentLinesCalculator2D::Points> tangents; // per link, rows as getTangentLines0
+    double meshMaxDistance = 0;
+    ArmChainLayout chainLayout;
+};
+
+inline ArmChainParameters ArmChainParameters::fromArm(const ArmParameters &p)
+{
+    ArmChainParameters chain;
+    chain.radius = {p.R0, p.R1, p.R2};
+    chain.length = {p.length0, p.length1};
+    chain.angle = {p.Rad0, p.Rad0 + p.Rad1};
+    chain.d = p.d;
+    chain.MeshMaxDistance = p.MeshMaxDistance;
+    chain.thickness = p.thickness;
+    return chain;
+}
+
+template <typename Function>
+void ArmChainBuilder::forEach(int count, Function function)
+{
+    if (pool && count > grain)
+        pool->parallelFor(0, count, grain, function);
+    else
+        for (int i = 0; i < count; i++)
+            function(i);
+}
+
+//* GEOMETRIC MATH----------------------------------------------------------------------------------------------------------------------------------------------------------------
+inline const ArmChainLayout &ArmChainBuilder::prepare(const ArmChainParameters &p)
+{
+    const int N = p.links();
+    chainLayout = ArmChainLayout();
+    chainLayout.links = N;
+    joints.assign(N + 1, Joint());
+    tangents.resize(N);
+    meshMaxDistance = p.MeshMaxDistance;
+
+    //* Joint positions are a running sum of the link directions, cheap enough to do serially.
+    {
+        ARM_PROFILE_SCOPE(ArmStage::TangentSolve);
+        double direction = 0;
+        joints[0].P = Eigen::Vector2d(0, 0);
+        for (int j = 0; j < N; j++)
+        {
+            direction = j == 0 ? p.angle[0] : direction - p.angle[j];
+            joints[j + 1].P = joints[j].P + Eigen::Vector2d(std::cos(direction) * p.length[j], std::sin(direction) * p.length[j]);
+        }
+
+        forEach(N, [&](int j)
+                {
+            TangentLinesCalculator2D tangentLinesCalculator;
+            tangents[j] = tangentLinesCalculator.getTangentLines0(joints[j].P, p.radius[j], joints[j + 1].P, p.radius[j + 1]); });
+
+        forEach(N + 1, [&](int j)
+                { solveJoint(j, p); });
+    }
+
+    {
+        ARM_PROFILE_SCOPE(ArmStage::ArcDivision);
+        forEach(N + 1, [&](int j)
+                { countJoint(j); });
+    }
+
+    //* Prefix sums over the segments.
+    int vertexOffset = 0, faceOffset = 0;
+    for (int j = 0; j <= N; j++)
+    {
+        Joint &joint = joints[j];
+        joint.vertexOffset = vertexOffset;
+        int offset = vertexOffset + 1; // Pj first
+        for (int k = 0; k < joint.arcCount; k++)
+        {
+            joint.arcs[k].offset = offset;
+            offset += joint.arcs[k].points;
+        }
+        joint.vertexCount = offset - vertexOffset;
+        joint.faceOffset = faceOffset;
+        vertexOffset = offset;
+        faceOffset += 2 * joint.frontFaces + joint.sideFaces;
+    }
+
+    chainLayout.frontVertices = vertexOffset;
+    chainLayout.vertices = 2 * vertexOffset;
+    chainLayout.faces = faceOffset;
+    return chainLayout;
+}
+
+inline void ArmChainBuilder::solveJoint(int j, const ArmChainParameters &p)
+{
+    const int N = p.links();
+    Joint &joint = joints[j];
+
+    //* Same arcs as ArmMeshBuilder: arc0 at P0, arc3 at PN, arc1 and the fillet arc2 at every inner joint.
+    if (j == 0)
+    {
+        joint.arcs[0].center = joint.P;
+        joint.arcs[0].radius = p.radius[0];
+        joint.arcs[0].start = tangents[0].row(0);
+        joint.arcs[0].end = tangents[0].row(2);
+    }
+    else if (j == N)
+    {
+        joint.arcs[0].center = joint.P;
+        joint.arcs[0].radius = p.radius[N];
+        joint.arcs[0].start = tangents[N - 1].row(3);
+        joint.arcs[0].end = tangents[N - 1].row(1);
+    }
+    else
+    {
+        joint.arcCount = 2;
+        joint.arcs[0].center = joint.P;
+        joint.arcs[0].radius = p.radius[j];
+        joint.arcs[0].start = tangents[j].row(0);
+        joint.arcs[0].end = tangents[j - 1].row(1);
+
+        TangentCircleCalculator2D tangentCircleCalculator;
+        TangentCircleCalculator2D::Points tanPoints;
+        std::pair<Eigen::Vector2d, double> centerRadius = tangentCircleCalculator.getTangentCircleCenter(tangents[j - 1].row(2), tangents[j - 1].row(3), tangents[j].row(3), tangents[j].row(2), p.d, tanPoints);
+        joint.arcs[1].center = centerRadius.first;
+        joint.arcs[1].radius = centerRadius.second;
+        joint.arcs[1].start = tanPoints.row(1);
+        joint.arcs[1].end = tanPoints.row(0);
+    }
+}
+
+inline void ArmChainBuilder::countJoint(int j)
+{
+    Joint &joint = joints[j];
+    CircleArcDivider2D circleArcDivider(ArcTessellation::Recurrence);
+    for (int k = 0; k < joint.arcCount; k++)
+    {
+        ChainArc &arc = joint.arcs[k];
+        arc.points = circleArcDivider.countArcPoints(arc.center, arc.radius, arc.start, arc.end, meshMaxDistance);
+    }
+
+    //* One fan triangle and two side triangles per arc segment, a link adds 4 cap and 4 side triangles.
+    int arcSegments = 0;
+    for (int k = 0; k < joint.arcCount; k++)
+        arcSegments += joint.arcs[k].points - 1;
+    bool hasLink = j < chainLayout.links;
+    joint.frontFaces = arcSegments + (hasLink ? 4 : 0);
+    joint.sideFaces = 2 * arcSegments + (hasLink ? 4 : 0);
+}
+
+//* MESH----------------------------------------------------------------------------------------------------------------------------------------------------------------
+inline bool ArmChainBuilder::build(const ArmChainParameters &p, Eigen::MatrixXd &V, Eigen::MatrixXi &F)
+{
+    if (!p.valid())
+    {
+        chainLayout = ArmChainLayout();
+        V.resize(0, 3);
+        F.resize(0, 3);
+        return false;
+    }
+
+    prepare(p);
+    V.resize(chainLayout.vertices, 3);
+    F.resize(chainLayout.faces, 3);
+
+    const int segments = chainLayout.links + 1;
+    {
+        ARM_PROFILE_SCOPE(ArmStage::ArcDivision);
+        forEach(segments, [&](int j)
+                { writeSegmentArcs(j, V); });
+    }
+    {
+        ARM_PROFILE_SCOPE(ArmStage::VertexAssembly);
+        forEach(segments, [&](int j)
+                { writeSegmentVertices(j, p.thickness, V); });
+    }
+    {
+        ARM_PROFILE_SCOPE(ArmStage::FaceAssembly);
+        forEach(segments, [&](int j)
+                { writeSegmentFaces(j, F); });
+    }
+    ARM_PROFILE_COMMIT(chainLayout.vertices, chainLayout.faces);
+    return true;
+}
+
+inline void ArmChainBuilder::writeSegmentArcs(int j, Eigen::MatrixXd &V) const
+{
+    const Joint &joint = joints[j];
+    CircleArcDivider2D circleArcDivider(ArcTessellation::Recurrence);
+    for (int k = 0; k < joint.arcCount; k++)
+    {
+        const ChainArc &arc = joint.arcs[k];
+        circleArcDivider.divideArc2D(arc.center, arc.radius, arc.start, arc.end, meshMaxDistance, V.middleRows(arc.offset, arc.points));
+    }
+}
+
+//* After writeSegmentArcs of the same segment: the back copies its front vertices.
+inline void ArmChainBuilder::writeSegmentVertices(int j, double thickness, Eigen::MatrixXd &V) const
+{
+    const Joint &joint = joints[j];
+    const int nf = chainLayout.frontVertices;
+    V(joint.vertexOffset, 0) = joint.P.x();
+    V(joint.vertexOffset, 1) = joint.P.y();
+    V(joint.vertexOffset, 2) = 0;
+    for (int i = joint.vertexOffset; i < joint.vertexOffset + joint.vertexCount; i++)
+    {
+        V(nf + i, 0) = V(i, 0);
+        V(nf + i, 1) = V(i, 1);
+        V(nf + i, 2) = -thickness;
+    }
+}
+
+inline void ArmChainBuilder::writeSegmentFaces(int j, Eigen::MatrixXi &F) const
+{
+    const Joint &joint = joints[j];
+    const int nf = chainLayout.frontVertices;
+    int row = joint.faceOffset;
+    auto put = [&](int a, int b, int c)
+    {
+        F(row, 0) = a;
+        F(row, 1) = b;
+        F(row, 2) = c;
+        row++;
+    };
+    // Front
+    emitFrontFaces(j, put);
+    // Back, mirrored winding
+    emitFrontFaces(j, [&](int a, int b, int c)
+                   { put(a + nf, c + nf, b + nf); });
+    // Sides
+    emitSideFaces(j, put);
+}
+
+inline int ArmChainBuilder::outerStart(int link) const
+{
+    //* Start of the cap arc of P0 or of the outer arc of joint j, both tangents[j].row(0).
+    return joints[link].arcs[0].offset;
+}
+
+inline int ArmChainBuilder::innerStart(int link) const
+{
+    //* End of the cap arc of P0 (tangents[0].row(2)), or start of the fillet of joint j.
+    const Joint &joint = joints[link];
+    return link == 0 ? joint.arcs[0].offset + joint.arcs[0].points - 1 : joint.arcs[1].offset;
+}
+
+inline int ArmChainBuilder::outerEnd(int link) const
+{
+    //* End of the outer arc of joint j + 1 or of the cap arc of PN, both tangents[j].row(1).
+    const ChainArc &arc = joints[link + 1].arcs[0];
+    return arc.offset + arc.points - 1;
+}
+
+inline int ArmChainBuilder::innerEnd(int link) const
+{
+    //* End of the fillet of joint j + 1, or start of the cap arc of PN (tangents[j].row(3)).
+    const Joint &joint = joints[link + 1];
+    return link + 1 == chainLayout.links ? joint.arcs[0].offset : joint.arcs[1].offset + joint.arcs[1].points - 1;
+}
+
+//* Counterclockwise seen from +z: the outline runs along the cap and outer arcs in their division order
+//* and along the fillets against it, so the fillet fans are reversed.
+template <typename Emit>
+void ArmChainBuilder::emitFrontFaces(int j, Emit &&emit) const
+{
+    const Joint &joint = joints[j];
+    const int center = joint.vertexOffset;
+
+    const ChainArc &arc = joint.arcs[0];
+    for (int i = arc.offset; i < arc.offset + arc.points - 1; i++)
+        emit(center, i, i + 1);
+    if (joint.arcCount == 2)
+    {
+        const ChainArc &fillet = joint.arcs[1];
+        for (int i = fillet.offset; i < fillet.offset + fillet.points - 1; i++)
+            emit(center, i + 1, i);
+    }
+
+    if (j < chainLayout.links)
+    {
+        //* Link j: hexagon Pj, inner start, inner end, Pj+1, outer end, outer start, fanned from Pj.
+        const int next = joints[j + 1].vertexOffset;
+        emit(center, innerStart(j), innerEnd(j));
+        emit(center, innerEnd(j), next);
+        emit(center, next, outerEnd(j));
+        emit(center, outerEnd(j), outerStart(j));
+    }
+}
+
+//* One quad per outline edge a -> b (counterclockwise), facing outwards.
+template <typename Emit>
+void ArmChainBuilder::emitSideFaces(int j, Emit &&emit) const
+{
+    const Joint &joint = joints[j];
+    const int nf = chainLayout.frontVertices;
+    auto quad = [&](int a, int b)
+    {
+        emit(a, nf + a, nf + b);
+        emit(a, nf + b, b);
+    };
+
+    const ChainArc &arc = joint.arcs[0];
+    for (int i = arc.offset; i < arc.offset + arc.points - 1; i++)
+        quad(i, i + 1);
+    if (joint.arcCount == 2)
+    {
+        const ChainArc &fillet = joint.arcs[1];
+        for (int i = fillet.offset; i < fillet.offset + fillet.points - 1; i++)
+            quad(i + 1, i);
+    }
+
+    if (j < chainLayout.links)
+    {
+        quad(innerStart(j), innerEnd(j));
+        quad(outerEnd(j), outerStart(j));
+    }
+}
@@ -0,0 +1,210 @@
+//* Author: Zac Zhuo Zhang
+//* Closed-form inverse kinematics of the two-link arm: the joint angles that put P2 on a target point.
+//* Forward kinematics (ArmMeshBuilder): P1 = length0 (cos Rad0, sin Rad0), P2 = P1 + length1 (cos -Rad1, sin -Rad1),
+//* so link 1 turns by theta = -(Rad0 + Rad1) relative to link 0 and the law of cosines gives
+//*   cos theta = (|T|^2 - length0^2 - length1^2) / (2 length0 length1)
+//*   Rad0 = atan2(T) - atan2(length1 sin theta, length0 + length1 cos theta),  Rad1 = -(Rad0 + theta).
+//* Every target has two elbow solutions: solution 0 bends clockwise at P1 (theta <= 0, as the viewer's arm does),
+//* solution 1 counterclockwise. Targets out of reach get the fully stretched or folded pose towards the target.
+//* The angles are clamped to the joint limits (the viewer's slider range by default); flags tell whether
+//* the target was reachable and whether the solution needed no clamping.
+//*
+//* solveBatch takes structure-of-arrays targets and is branch free: atan2 is evaluated with a rational
+//* approximation (Cephes atan, full double precision) instead of a libm call, so the loop vectorizes
+//* (with -fno-trapping-math, which arm_kernel_flags sets on the project's executables; AVX2/NEON with ARM_NATIVE_ARCH). With a WorkStealingPool the batch is split across cores.
+//* buildMeshes optionally meshes one of the solutions of every target.
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ArmParameters.h"
+#include "ArmMeshBuilder.h"
+#include "WorkStealingPool.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ARM_IK_ALWAYS_INLINE __attribute__((always_inline))
+#else
+#define ARM_IK_ALWAYS_INLINE
+#endif
+
+struct ArmJointLimits
+{
+    double Rad0Min = 0.1;
+    double Rad0Max = 1.5;
+    double Rad1Min = 0.1;
+    double Rad1Max = 1.5;
+};
+
+enum ArmIkFlags : unsigned char
+{
+    IkReachable = 1 << 0,    // |P2 - target| is zero before clamping
+    IkWithinLimits = 1 << 1, // no angle was clamped
+    IkExact = IkReachable | IkWithinLimits
+};
+
+//* N end-effector targets in the XY plane, as structure-of-arrays.
+struct IkTargetsSoA
+{
+    const double *x, *y;
+    int count;
+};
+
+//* Both solutions of N targets, as structure-of-arrays: Rad0[s][i], Rad1[s][i], flags[s][i] is solution s of target i.
+struct IkSolutionsSoA
+{
+    double *Rad0[2];
+    double *Rad1[2];
+    unsigned char *flags[2];
+};
+
+class ArmInverseKinematics
+{
+public:
+    //* Without a pool, everything runs on the calling thread.
+    explicit ArmInverseKinematics(WorkStealingPool *pool = nullptr) : pool(pool) {}
+
+    ArmJointLimits limits;
+    //* Targets (or meshes) per parallel task.
+    int grain = 4096;
+
+    //* Both solutions for one target, with the link lengths of p.
+    void solve(const ArmParameters &p, const Eigen::Vector2d &target, double Rad0[2], double Rad1[2], unsigned char flags[2]) const;
+    void solveBatch(const ArmParameters &p, const IkTargetsSoA &targets, const IkSolutionsSoA &solutions);
+
+    //* Mesh solution (0 or 1) of the first count targets: p with Rad0/Rad1 replaced. V and F are resized to count.
+    void buildMeshes(const ArmParameters &p, const IkSolutionsSoA &solutions, int count, int solution, std::vector<Eigen::MatrixXd> &V, std::vector<Eigen::MatrixXi> &F);
+
+    //* atan2 without libm calls or branches, always inlined: the batch loop only vectorizes when no call is left in it.
+    ARM_IK_ALWAYS_INLINE static double atan2(double y, double x);
+
+private:
+    //* The vectorized kernel over [begin, end).
+    void solveRange(double length0, double length1, const IkTargetsSoA &targets, const IkSolutionsSoA &solutions, int begin, int end) const;
+
+    template <typename Function>
+    void forEachBlock(int count, Function function);
+
+    WorkStealingPool *pool;
+};
+
+inline double ArmInverseKinematics::atan2(double y, double x)
+{
+    //* Cephes atan on t = min / max in [0, 1], reduced to |t| <= 0.66 around pi/4, then the octant is undone.
+    const double P0 = -8.750608600031904122785e-1, P1 = -1.615753718733365076637e1, P2 = -7.500855792314704667340e1,
+                 P3 = -1.228866684490136173410e2, P4 = -6.485021904942025371773e1;
+    const double Q0 = 2.485846490142306297962e1, Q1 = 1.650270098316988542046e2, Q2 = 4.328810604912902668951e2,
+                 Q3 = 4.853903996359136964868e2, Q4 = 1.945506571482613964425e2;
+    const double MoreBits = 6.123233995736765886130e-17;
+
+    double ax = std::abs(x), ay = std::abs(y);
+    double high = std::max(ax, ay), low = std::min(ax, ay);
+    //* Both divisions are unconditional, a conditional division would keep the loop from being if-converted.
+    double t = low / (high > 0 ? high : 1);
+
+    bool reduce = t > 0.66;
+    double reduced = (t - 1) / (t + 1);
+    double u = reduce ? reduced : t;
+    double z = u * u;
+    double p = (((P0 * z + P1) * z + P2) * z + P3) * z + P4;
+    double q = ((((z + Q0) * z + Q1) * z + Q2) * z + Q3) * z + Q4;
+    double r = u + u * z * p / q + (reduce ? M_PI_4 + 0.5 * MoreBits : 0);
+
+    r = ay > ax ? M_PI_2 - r : r;
+    //* copysign instead of signbit (which does not vectorize), same signed zero handling as std::atan2.
+    r = std::copysign(1.0, x) < 0 ? M_PI - r : r;
+    return std::copysign(r, y);
+}
+
+inline void ArmInverseKinematics::solve(const ArmParameters &p, const Eigen::Vector2d &target, double Rad0[2], double Rad1[2], unsigned char flags[2]) const
+{
+    IkTargetsSoA targets = {&target.x(), &target.y(), 1};
+    IkSolutionsSoA solutions = {{&Rad0[0], &Rad0[1]}, {&Rad1[0], &Rad1[1]}, {&flags[0], &flags[1]}};
+    solveRange(p.length0, p.length1, targets, solutions, 0, 1);
+}
+
+inline void ArmInverseKinematics::solveRange(double length0, double length1, const IkTargetsSoA &targets, const IkSolutionsSoA &solutions, int begin, int end) const
+{
+    const double *__restrict x = targets.x, *__restrict y = targets.y;
+    double *__restrict rad0A = solutions.Rad0[0], *__restrict rad0B = solutions.Rad0[1];
+    double *__restrict rad1A = solutions.Rad1[0], *__restrict rad1B = solutions.Rad1[1];
+    unsigned char *__restrict flagsA = solutions.flags[0], *__restrict flagsB = solutions.flags[1];
+    const double Rad0Min = limits.Rad0Min, Rad0Max = limits.Rad0Max, Rad1Min = limits.Rad1Min, Rad1Max = limits.Rad1Max;
+    const double twoPi = 2 * M_PI;
+
+#pragma omp simd
+    for (int i = begin; i < end; i++)
+    {
+        double c = (x[i] * x[i] + y[i] * y[i] - length0 * length0 - length1 * length1) / (2 * length0 * length1);
+        //* A little slack so targets exactly on the workspace boundary count as reachable.
+        bool reachable = std::abs(c) <= 1 + 1e-12;
+        c = std::min(std::max(c, -1.0), 1.0);
+        double s = std::sqrt(1 - c * c);
+
+        //* theta = -alpha (solution 0) or +alpha (solution 1), beta the angle of P2 seen from link 0.
+        double direction = atan2(y[i], x[i]);
+        double alpha = atan2(s, c);
+        double beta = atan2(length1 * s, length0 + length1 * c);
+
+        double a0 = direction + beta, a1 = direction - beta;
+        //* Back to (-pi, pi], both comparisons always evaluated so the loop if-converts.
+        a0 += (a0 > M_PI ? -twoPi : 0) + (a0 <= -M_PI ? twoPi : 0);
+        a1 += (a1 > M_PI ? -twoPi : 0) + (a1 <= -M_PI ? twoPi : 0);
+        double b0 = alpha - a0, b1 = -alpha - a1;
+        b0 += (b0 > M_PI ? -twoPi : 0) + (b0 <= -M_PI ? twoPi : 0);
+        b1 += (b1 > M_PI ? -twoPi : 0) + (b1 <= -M_PI ? twoPi : 0);
+
+        bool within0 = (a0 >= Rad0Min) & (a0 <= Rad0Max) & (b0 >= Rad1Min) & (b0 <= Rad1Max);
+        bool within1 = (a1 >= Rad0Min) & (a1 <= Rad0Max) & (b1 >= Rad1Min) & (b1 <= Rad1Max);
+        rad0A[i] = std::min(std::max(a0, Rad0Min), Rad0Max);
+        rad1A[i] = std::min(std::max(b0, Rad1Min), Rad1Max);
+        rad0B[i] = std::min(std::max(a1, Rad0Min), Rad0Max);
+        rad1B[i] = std::min(std::max(b1, Rad1Min), Rad1Max);
+        //* Flags summed as doubles: narrowing double-wide masks to bytes does not vectorize on SSE2, a conversion does.
+        flagsA[i] = (unsigned char)(int)((reachable ? double(IkReachable) : 0.0) + (within0 ? double(IkWithinLimits) : 0.0));
+        flagsB[i] = (unsigned char)(int)((reachable ? double(IkReachable) : 0.0) + (within1 ? double(IkWithinLimits) : 0.0));
+    }
+}
+
+template <typename Function>
+void ArmInverseKinematics::forEachBlock(int count, Function function)
+{
+    const int blocks = (count + grain - 1) / grain;
+    auto block = [&](int b)
+    { function(b * grain, std::min(count, (b + 1) * grain)); };
+    if (pool && blocks > 1)
+        pool->parallelFor(0, blocks, 1, block);
+    else
+        for (int b = 0; b < blocks; b++)
+            block(b);
+}
+
+inline void ArmInverseKinematics::solveBatch(const ArmParameters &p, const IkTargetsSoA &targets, const IkSolutionsSoA &solutions)
+{
+    forEachBlock(targets.count, [&](int begin, int end)
+                 { solveRange(p.length0, p.length1, targets, solutions, begin, end); });
+}
+
+inline void ArmInverseKinematics::buildMeshes(const ArmParameters &p, const IkSolutionsSoA &solutions, int count, int solution, std::vector<Eigen::MatrixXd> &V, std::vector<Eigen::MatrixXi> &F)
+{
+    V.resize(count);
+    F.resize(count);
+    //* One builder per thread (plus the calling thread).
+    std::vector<ArmMeshBuilder> builders(pool ? pool->threadCount() + 1 : 1);
+    const int meshGrain = std::max(1, grain / 256);
+    auto build = [&](int i)
+    {
+        ArmParameters q = p;
+        q.Rad0 = solutions.Rad0[solution][i];
+        q.Rad1 = solutions.Rad1[solution][i];
+        builders[pool ? pool->currentThreadIndex() : 0].build(q, V[i], F[i]);
+    };
+    if (pool && count > meshGrain)
+        pool->parallelFor(0, count, meshGrain, build);
+    else
+        for (int i = 0; i < count; i++)
+            build(i);
+}
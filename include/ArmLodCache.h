@@ -0,0 +1,94 @@
+//* Author: Zac Zhuo Zhang
+//* Levels of detail of one arm: level k is meshed with MeshMaxDistance = coarsest * ratio^k.
+//* Every level is its own ArmModel, built the first time it is asked for and then kept, so switching
+//* between levels that are up to date rebuilds nothing. A parameter change makes all levels stale;
+//* a stale level is brought up to date incrementally when it is asked for again.
+//* selectLevel() picks the coarsest level whose segments stay below a tolerance in screen pixels.
+
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "ArmParameters.h"
+#include "ArmModel.h"
+
+class ArmLodCache
+{
+public:
+    explicit ArmLodCache(double coarsest = 0.1, double ratio = 0.5, int levels = 8, bool normals = false);
+
+    int levels() const { return (int)models.size(); }
+    double meshMaxDistance(int level) const { return coarsest * std::pow(ratio, level); }
+
+    //* MeshMaxDistance of p is ignored, each level uses its own.
+    void setParameters(const ArmParameters &p);
+    const ArmParameters &parameters() const { return params; }
+
+    //* The mesh of a level for the current parameters, built or updated on demand.
+    const ArmModel &level(int level);
+    //* True when level(level) would not recompute anything.
+    bool isBuilt(int level) const { return builtVersion[level] == version; }
+
+    //* Coarsest level whose MeshMaxDistance, seen at pixelsPerUnit screen pixels per model unit,
+    //* is at most pixelTolerance pixels. Falls back to the finest level.
+    int selectLevel(double pixelsPerUnit, double pixelTolerance = 3.0) const;
+
+private:
+    double coarsest;
+    double ratio;
+    ArmParameters params;
+    std::vector<ArmModel> models;
+    std::vector<unsigned long long> builtVersion; // parameter version each level was last updated to
+    unsigned long long version = 1;
+};
+
+inline ArmLodCache::ArmLodCache(double coarsest, double ratio, int levels, bool normals) : coarsest(coarsest), ratio(ratio), builtVersion(levels, 0)
+{
+    //* ArmModel allocates nothing before its first update(), so unused levels stay empty.
+    models.reserve(levels);
+    for (int k = 0; k < levels; k++)
+    {
+        ArmParameters p = params;
+        p.MeshMaxDistance = meshMaxDistance(k);
+        models.emplace_back(p, normals);
+    }
+}
+
+inline void ArmLodCache::setParameters(const ArmParameters &p)
+{
+    for (int k = 0; k < ArmParameters::Count; k++)
+    {
+        if (k != 8 && p[k] != params[k]) // 8: MeshMaxDistance
+        {
+            params = p;
+            version++;
+            return;
+        }
+    }
+}
+
+inline const ArmModel &ArmLodCache::level(int level)
+{
+    ArmModel &model = models[level];
+    if (builtVersion[level] != version)
+    {
+        ArmParameters p = params;
+        p.MeshMaxDistance = meshMaxDistance(level);
+        model.setParameters(p);
+        model.update();
+        builtVersion[level] = version;
+    }
+    return model;
+}
+
+inline int ArmLodCache::selectLevel(double pixelsPerUnit, double pixelTolerance) const
+{
+    if (!(pixelsPerUnit > 0))
+        return 0;
+    double allowed = pixelTolerance / pixelsPerUnit;
+    for (int k = 0; k < levels(); k++)
+        if (meshMaxDistance(k) <= allowed)
+            return k;
+    return levels() - 1;
+}
@@ -0,0 +1,633 @@
+//* Author: Zac Zhuo Zhang
+//* Single-pass arm mesh builder.
+//* prepare() solves the tangent lines and the fillet circle and counts the points of the four arcs,
+//* which gives the exact vertex and face counts before anything is written.
+//* build() then writes every vertex and triangle directly into caller-owned V and F.
+//* Eigen only reallocates V and F when their size changes, so repeated builds at the same
+//* resolution do no heap allocation at all; keep one builder (and one V/F) per thread and reuse them.
+//* Arcs use the recurrence tessellation of CircleArcDivider2D.
+//* prepare() with fixed arc point counts divides every arc into exactly that many points instead, so a
+//* moving arm keeps one topology across frames (ArmTrajectoryBaker).
+//* With ARM_PROFILING, every stage is timed and build() commits one profiler sample per stage.
+//*
+//* Front vertex layout (the back vertices follow in the same order at z = -thickness):
+//*   arc0 (around P0) | arc1 (around P1) | arc2 (fillet) | arc3 (around P2) | P0 | P2
+//* A builder constructed with splitSides appends a separate copy of the arc points for the side walls
+//* (front copies, then back copies), so the cap/side crease is sharp and every vertex has one exact normal:
+//* +z / -z on the caps, the in-plane circle normal on the sides (the outline is tangent continuous,
+//* so the link sides share the normals of the arc end points). The side faces use those copies.
+//* stream() sends the same mesh to an ArmMeshSink instead: only the front outline is kept (in the builder),
+//* the back and side vertices are derived from it on the fly and the faces come straight from emitFaces.
+//* Templated on the scalar the profile is solved in (ArmMeshBuilder: double, ArmMeshBuilderf: float). The
+//* writers take any Eigen matrix, so the output precision is chosen separately: a double builder can write
+//* float V (MatrixXf, or a row-major map of a GPU buffer) directly, without a converting copy.
+//* Face layout:
+//*   front faces | back faces | sides of arc0 | sides of arc3 | sides of link0 | sides of arc1 | sides of arc2 | sides of link1
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "ArmParameters.h"
+#include "TangentLinesCalculator.h"
+#include "TangentCircleCalculator.h"
+#include "DivideArc.h"
+#include "ArmProfiler.h"
+#include "ArmMeshSink.h"
+
+struct ArmMeshLayout
+{
+    int arcPoints[4] = {0, 0, 0, 0}; // arc0 (around P0), arc1 (around P1), arc2 (fillet), arc3 (around P2)
+    int arcOffset[4] = {0, 0, 0, 0}; // first front vertex of each arc
+    int indexP0 = 0;
+    int indexP2 = 0;
+    int frontVertices = 0;
+    int sideOffset = 0;   // first side wall vertex, only with split sides
+    int sideVertices = 0; // front and back copies of the arc points, 0 without split sides
+    int vertices = 0;
+    int frontFaces = 0;
+    int faces = 0;
+
+    bool sameTopology(const ArmMeshLayout &other) const
+    {
+        return arcPoints[0] == other.arcPoints[0] && arcPoints[1] == other.arcPoints[1] && arcPoints[2] == other.arcPoints[2] && arcPoints[3] == other.arcPoints[3] && sideVertices == other.sideVertices;
+    }
+
+    //* The triangles only depend on the layout, see ArmMeshBuilder for the face order.
+    template <typename Emit>
+    void emitFrontFaces(Emit &&emit) const;
+    template <typename Emit>
+    void emitSideFaces(Emit &&emit) const;
+    template <typename Emit>
+    void emitFaces(Emit &&emit) const;
+};
+
+template <typename Scalar>
+class BasicArmMeshBuilder
+{
+public:
+    typedef Eigen::Matrix<Scalar, 2, 1> Point;
+
+    explicit BasicArmMeshBuilder(bool splitSides = false) : splitSides(splitSides) {}
+
+    bool hasSplitSides() const { return splitSides; }
+
+    //* Solve the 2D profile primitives and compute the layout, nothing is written yet.
+    const ArmMeshLayout &prepare(const ArmParameters &p);
+    //* Same, with the given point count (at least 2) per arc instead of MeshMaxDistance.
+    const ArmMeshLayout &prepare(const ArmParameters &p, const int arcPoints[4]);
+
+    //* prepare(p) followed by writing the whole mesh, V of any scalar type (MatrixXd, MatrixXf, ...).
+    template <typename DerivedV>
+    void build(const ArmParameters &p, Eigen::PlainObjectBase<DerivedV> &V, Eigen::MatrixXi &F);
+    //* Same, plus per-vertex normals. Needs a builder constructed with splitSides.
+    template <typename DerivedV, typename DerivedN>
+    void build(const ArmParameters &p, Eigen::PlainObjectBase<DerivedV> &V, Eigen::MatrixXi &F, Eigen::PlainObjectBase<DerivedN> &N);
+
+    //* prepare(p) followed by streaming the mesh into sink, in the same vertex and face order as build().
+    //* Returns sink.end().
+    bool stream(const ArmParameters &p, ArmMeshSink &sink);
+
+    const ArmMeshLayout &layout() const { return meshLayout; }
+    //* Circle of arc k (0: around P0, 1: around P1, 2: fillet, 3: around P2), valid after prepare().
+    const Point &circleCenter(int arc) const { return arcCenter[arc]; }
+    Scalar circleRadius(int arc) const { return arcRadius[arc]; }
+    //* First and last point of arc k, and the angle between its consecutive points (see CircleArcDivider2D::arcStep).
+    const Point &arcFirstPoint(int arc) const { return arcStart[arc]; }
+    const Point &arcLastPoint(int arc) const { return arcEnd[arc]; }
+    Scalar arcStep(int arc) const;
+
+    //* prepare() in stages, so a caller can redo only what a parameter change affects:
+    //* link 0 (P1, tangents of P0-P1), link 1 (P2, tangents of P1-P2), the fillet (needs both links),
+    //* and the arc point counts. layoutArcs returns false when the topology did not change.
+    void solveLink0(const ArmParameters &p);
+    void solveLink1(const ArmParameters &p);
+    void solveFillet(const ArmParameters &p);
+    bool layoutArcs(double MeshMaxDistance);
+    bool layoutArcs(const int arcPoints[4]);
+
+    //* Writing stages, valid after prepare(). V and F must already have the layout's size.
+    //* V has 3 columns; writeArc, writeCenters and writeFrontVertices also take a 2-column outline (x, y).
+    template <typename Derived>
+    void writeArc(int arc, Eigen::MatrixBase<Derived> &V);
+    template <typename Derived>
+    void writeCenters(Eigen::MatrixBase<Derived> &V) const;
+    template <typename Derived>
+    void writeFrontVertices(Eigen::MatrixBase<Derived> &V);
+    //* Copy front vertices [first, first + count) to the back at z = -thickness (and to the side walls),
+    //* count < 0 means all.
+    template <typename Derived>
+    void writeBackVertices(Eigen::MatrixBase<Derived> &V, double thickness, int first = 0, int count = -1) const;
+    //* Only move the back (and side back) vertices to z = -thickness.
+    template <typename Derived>
+    void writeThickness(Eigen::MatrixBase<Derived> &V, double thickness) const;
+    void writeFaces(Eigen::MatrixXi &F) const;
+
+    //* Normals of a split-sides mesh, from the written vertices. N must have the layout's size.
+    template <typename DerivedV, typename DerivedN>
+    void writeNormals(const Eigen::MatrixBase<DerivedV> &V, Eigen::MatrixBase<DerivedN> &N) const;
+    template <typename DerivedN>
+    void writeCapNormals(Eigen::MatrixBase<DerivedN> &N) const;
+    template <typename DerivedV, typename DerivedN>
+    void writeArcNormals(int arc, const Eigen::MatrixBase<DerivedV> &V, Eigen::MatrixBase<DerivedN> &N) const;
+
+    //* Call emit(a, b, c) for every triangle of the front cap, in face order.
+    template <typename Emit>
+    void emitFrontFaces(Emit &&emit) const;
+    //* Call emit(a, b, c) for every triangle of the side walls, in face order.
+    template <typename Emit>
+    void emitSideFaces(Emit &&emit) const;
+    //* Call emit(a, b, c) for every triangle, in face order.
+    template <typename Emit>
+    void emitFaces(Emit &&emit) const;
+
+private:
+    bool splitSides = false;
+
+    BasicTangentLinesCalculator2D<Scalar> tangentLinesCalculator;
+    BasicTangentCircleCalculator2D<Scalar> tangentCircleCalculator;
+    BasicCircleArcDivider2D<Scalar> circleArcDivider{ArcTessellation::Recurrence};
+
+    Point P0, P1, P2;
+    typename BasicTangentLinesCalculator2D<Scalar>::Points tan0Points, tan1Points;
+    typename BasicTangentCircleCalculator2D<Scalar>::Points tanPoints;
+
+    //* Center, radius and end points of the four arcs.
+    Point arcCenter[4];
+    Scalar arcRadius[4];
+    Point arcStart[4];
+    Point arcEnd[4];
+    Scalar meshMaxDistance = 0;
+    bool fixedArcs = false;
+
+    //* Offsets and counts from meshLayout.arcPoints.
+    bool finishLayout(const ArmMeshLayout &previous);
+
+    ArmMeshLayout meshLayout;
+    Eigen::Matrix<Scalar, Eigen::Dynamic, 2> outline; // front vertices for stream()
+};
+
+typedef BasicArmMeshBuilder<double> ArmMeshBuilder;
+typedef BasicArmMeshBuilder<float> ArmMeshBuilderf;
+
+template <typename Scalar>
+const ArmMeshLayout &BasicArmMeshBuilder<Scalar>::prepare(const ArmParameters &p)
+{
+    solveLink0(p);
+    solveLink1(p);
+    solveFillet(p);
+    layoutArcs(p.MeshMaxDistance);
+    return meshLayout;
+}
+
+template <typename Scalar>
+const ArmMeshLayout &BasicArmMeshBuilder<Scalar>::prepare(const ArmParameters &p, const int arcPoints[4])
+{
+    solveLink0(p);
+    solveLink1(p);
+    solveFillet(p);
+    layoutArcs(arcPoints);
+    return meshLayout;
+}
+
+//* GEOMETRIC MATH----------------------------------------------------------------------------------------------------------------------------------------------------------------
+template <typename Scalar>
+void BasicArmMeshBuilder<Scalar>::solveLink0(const ArmParameters &p)
+{
+    ARM_PROFILE_SCOPE(ArmStage::TangentSolve);
+    const Scalar length0 = Scalar(p.length0), Rad0 = Scalar(p.Rad0);
+    P0 = Point(0, 0);
+    P1 = Point(length0 * std::cos(Rad0), length0 * std::sin(Rad0));
+
+    tan0Points = tangentLinesCalculator.getTangentLines0(P0, Scalar(p.R0), P1, Scalar(p.R1));
+
+    arcCenter[0] = P0;
+    arcRadius[0] = Scalar(p.R0);
+    arcStart[0] = tan0Points.row(0);
+    arcEnd[0] = tan0Points.row(2);
+
+    arcEnd[1] = tan0Points.row(1);
+}
+
+template <typename Scalar>
+void BasicArmMeshBuilder<Scalar>::solveLink1(const ArmParameters &p)
+{
+    ARM_PROFILE_SCOPE(ArmStage::TangentSolve);
+    const Scalar length1 = Scalar(p.length1), Rad1 = Scalar(p.Rad1);
+    P2 = P1 + Point(std::cos(-Rad1) * length1, std::sin(-Rad1) * length1);
+
+    tan1Points = tangentLinesCalculator.getTangentLines0(P1, Scalar(p.R1), P2, Scalar(p.R2));
+
+    arcCenter[1] = P1;
+    arcRadius[1] = Scalar(p.R1);
+    arcStart[1] = tan1Points.row(0);
+
+    arcCenter[3] = P2;
+    arcRadius[3] = Scalar(p.R2);
+    arcStart[3] = tan1Points.row(3);
+    arcEnd[3] = tan1Points.row(1);
+}
+
+template <typename Scalar>
+void BasicArmMeshBuilder<Scalar>::solveFillet(const ArmParameters &p)
+{
+    ARM_PROFILE_SCOPE(ArmStage::TangentSolve);
+    std::pair<Point, Scalar> centerRadius = tangentCircleCalculator.getTangentCircleCenter(tan0Points.row(2), tan0Points.row(3), tan1Points.row(3), tan1Points.row(2), Scalar(p.d), tanPoints);
+
+    arcCenter[2] = centerRadius.first;
+    arcRadius[2] = centerRadius.second;
+    arcStart[2] = tanPoints.row(1);
+    arcEnd[2] = tanPoints.row(0);
+}
+
+template <typename Scalar>
+Scalar BasicArmMeshBuilder<Scalar>::arcStep(int arc) const
+{
+    if (fixedArcs)
+        return circleArcDivider.arcStep(arcCenter[arc], arcStart[arc], arcEnd[arc], meshLayout.arcPoints[arc]);
+    return circleArcDivider.arcStep(arcCenter[arc], arcRadius[arc], arcStart[arc], arcEnd[arc], meshMaxDistance);
+}
+
+//* LAYOUT----------------------------------------------------------------------------------------------------------------------------------------------------------------
+template <typename Scalar>
+bool BasicArmMeshBuilder<Scalar>::layoutArcs(double MeshMaxDistance)
+{
+    ARM_PROFILE_SCOPE(ArmStage::ArcDivision);
+    meshMaxDistance = Scalar(MeshMaxDistance);
+    fixedArcs = false;
+
+    ArmMeshLayout previous = meshLayout;
+    for (int k = 0; k < 4; k++)
+        meshLayout.arcPoints[k] = circleArcDivider.countArcPoints(arcCenter[k], arcRadius[k], arcStart[k], arcEnd[k], meshMaxDistance);
+    return finishLayout(previous);
+}
+
+template <typename Scalar>
+bool BasicArmMeshBuilder<Scalar>::layoutArcs(const int arcPoints[4])
+{
+    fixedArcs = true;
+
+    ArmMeshLayout previous = meshLayout;
+    for (int k = 0; k < 4; k++)
+        meshLayout.arcPoints[k] = std::max(arcPoints[k], 2);
+    return finishLayout(previous);
+}
+
+template <typename Scalar>
+bool BasicArmMeshBuilder<Scalar>::finishLayout(const ArmMeshLayout &previous)
+{
+    int offset = 0;
+    for (int k = 0; k < 4; k++)
+    {
+        meshLayout.arcOffset[k] = offset;
+        offset += meshLayout.arcPoints[k];
+    }
+    meshLayout.indexP0 = offset;
+    meshLayout.indexP2 = offset + 1;
+    meshLayout.frontVertices = offset + 2;
+    meshLayout.sideOffset = splitSides ? 2 * meshLayout.frontVertices : 0;
+    meshLayout.sideVertices = splitSides ? 2 * offset : 0;
+    meshLayout.vertices = 2 * meshLayout.frontVertices + meshLayout.sideVertices;
+
+    //* Each cap has (n0 - 1) + 3 + (n1 - 1) + (n2 - 1) + 3 + (n3 - 1) triangles, which is the front vertex count,
+    //* and every arc segment plus the two link sides gives a quad on the side walls.
+    meshLayout.frontFaces = meshLayout.frontVertices;
+    meshLayout.faces = 2 * meshLayout.frontFaces + 2 * (meshLayout.frontVertices - 2);
+
+    return !meshLayout.sameTopology(previous);
+}
+
+template <typename Scalar>
+template <typename DerivedV>
+void BasicArmMeshBuilder<Scalar>::build(const ArmParameters &p, Eigen::PlainObjectBase<DerivedV> &V, Eigen::MatrixXi &F)
+{
+    prepare(p);
+
+    V.resize(meshLayout.vertices, 3);
+    F.resize(meshLayout.faces, 3);
+
+    writeFrontVertices(V);
+    writeBackVertices(V, p.thickness);
+    writeFaces(F);
+    ARM_PROFILE_COMMIT(meshLayout.vertices, meshLayout.faces);
+}
+
+template <typename Scalar>
+template <typename DerivedV, typename DerivedN>
+void BasicArmMeshBuilder<Scalar>::build(const ArmParameters &p, Eigen::PlainObjectBase<DerivedV> &V, Eigen::MatrixXi &F, Eigen::PlainObjectBase<DerivedN> &N)
+{
+    prepare(p);
+
+    V.resize(meshLayout.vertices, 3);
+    F.resize(meshLayout.faces, 3);
+    N.resize(meshLayout.vertices, 3);
+
+    writeFrontVertices(V);
+    writeBackVertices(V, p.thickness);
+    writeFaces(F);
+    writeNormals(V, N);
+    ARM_PROFILE_COMMIT(meshLayout.vertices, meshLayout.faces);
+}
+
+template <typename Scalar>
+bool BasicArmMeshBuilder<Scalar>::stream(const ArmParameters &p, ArmMeshSink &sink)
+{
+    prepare(p);
+
+    const int nf = meshLayout.frontVertices, ns = meshLayout.sideVertices / 2;
+    outline.resize(nf, 2);
+    writeFrontVertices(outline);
+
+    //* Vertex i of the build() layout.
+    auto position = [&](int i)
+    {
+        bool back = false;
+        if (ns > 0 && i >= meshLayout.sideOffset)
+        {
+            i -= meshLayout.sideOffset;
+            back = i >= ns;
+            i -= back ? ns : 0;
+        }
+        else if (i >= nf)
+        {
+            i -= nf;
+            back = true;
+        }
+        return Eigen::Vector3d(outline(i, 0), outline(i, 1), back ? -p.thickness : 0.0);
+    };
+
+    sink.begin(meshLayout.vertices, meshLayout.faces);
+    for (int i = 0; i < meshLayout.vertices; i++)
+    {
+        Eigen::Vector3d v = position(i);
+        sink.vertex(v.x(), v.y(), v.z());
+    }
+    emitFaces([&](int a, int b, int c)
+              { sink.face(a, b, c, position(a), position(b), position(c)); });
+    return sink.end();
+}
+
+template <typename Scalar>
+template <typename Derived>
+void BasicArmMeshBuilder<Scalar>::writeArc(int arc, Eigen::MatrixBase<Derived> &V)
+{
+    ARM_PROFILE_SCOPE(ArmStage::ArcDivision);
+    if (fixedArcs)
+        circleArcDivider.divideArc2D(arcCenter[arc], arcStart[arc], arcEnd[arc], V.middleRows(meshLayout.arcOffset[arc], meshLayout.arcPoints[arc]));
+    else
+        circleArcDivider.divideArc2D(arcCenter[arc], arcRadius[arc], arcStart[arc], arcEnd[arc], meshMaxDistance, V.middleRows(meshLayout.arcOffset[arc], meshLayout.arcPoints[arc]));
+}
+
+template <typename Scalar>
+template <typename Derived>
+void BasicArmMeshBuilder<Scalar>::writeCenters(Eigen::MatrixBase<Derived> &V) const
+{
+    ARM_PROFILE_SCOPE(ArmStage::VertexAssembly);
+    typedef typename Derived::Scalar Output;
+    V(meshLayout.indexP0, 0) = Output(P0.x());
+    V(meshLayout.indexP0, 1) = Output(P0.y());
+    V(meshLayout.indexP2, 0) = Output(P2.x());
+    V(meshLayout.indexP2, 1) = Output(P2.y());
+    if (V.cols() > 2)
+        V(meshLayout.indexP0, 2) = V(meshLayout.indexP2, 2) = Output(0);
+}
+
+template <typename Scalar>
+template <typename Derived>
+void BasicArmMeshBuilder<Scalar>::writeFrontVertices(Eigen::MatrixBase<Derived> &V)
+{
+    for (int k = 0; k < 4; k++)
+        writeArc(k, V);
+    writeCenters(V);
+}
+
+template <typename Scalar>
+template <typename Derived>
+void BasicArmMeshBuilder<Scalar>::writeBackVertices(Eigen::MatrixBase<Derived> &V, double thickness, int first, int count) const
+{
+    ARM_PROFILE_SCOPE(ArmStage::VertexAssembly);
+    typedef typename Derived::Scalar Output;
+    int nf = meshLayout.frontVertices;
+    if (count < 0)
+        count = nf - first;
+    for (int i = first; i < first + count; i++)
+    {
+        V(nf + i, 0) = V(i, 0);
+        V(nf + i, 1) = V(i, 1);
+        V(nf + i, 2) = Output(-thickness);
+    }
+    if (!splitSides)
+        return;
+
+    //* Side copies of the arc points only, P0 and P2 are not on the side walls.
+    const int ns = meshLayout.sideVertices / 2, side = meshLayout.sideOffset;
+    for (int i = first; i < std::min(first + count, ns); i++)
+    {
+        V(side + i, 0) = V(i, 0);
+        V(side + i, 1) = V(i, 1);
+        V(side + i, 2) = Output(0);
+        V(side + ns + i, 0) = V(i, 0);
+        V(side + ns + i, 1) = V(i, 1);
+        V(side + ns + i, 2) = Output(-thickness);
+    }
+}
+
+template <typename Scalar>
+template <typename Derived>
+void BasicArmMeshBuilder<Scalar>::writeThickness(Eigen::MatrixBase<Derived> &V, double thickness) const
+{
+    ARM_PROFILE_SCOPE(ArmStage::VertexAssembly);
+    typedef typename Derived::Scalar Output;
+    V.col(2).segment(meshLayout.frontVertices, meshLayout.frontVertices).setConstant(Output(-thickness));
+    V.col(2).segment(meshLayout.sideOffset + meshLayout.sideVertices / 2, meshLayout.sideVertices / 2).setConstant(Output(-thickness));
+}
+
+template <typename Scalar>
+void BasicArmMeshBuilder<Scalar>::writeFaces(Eigen::MatrixXi &F) const
+{
+    ARM_PROFILE_SCOPE(ArmStage::FaceAssembly);
+    int row = 0;
+    emitFaces([&](int a, int b, int c)
+              {
+        F(row, 0) = a;
+        F(row, 1) = b;
+        F(row, 2) = c;
+        row++; });
+}
+
+template <typename Scalar>
+template <typename DerivedV, typename DerivedN>
+void BasicArmMeshBuilder<Scalar>::writeNormals(const Eigen::MatrixBase<DerivedV> &V, Eigen::MatrixBase<DerivedN> &N) const
+{
+    writeCapNormals(N);
+    for (int k = 0; k < 4; k++)
+        writeArcNormals(k, V, N);
+}
+
+template <typename Scalar>
+template <typename DerivedN>
+void BasicArmMeshBuilder<Scalar>::writeCapNormals(Eigen::MatrixBase<DerivedN> &N) const
+{
+    ARM_PROFILE_SCOPE(ArmStage::VertexAssembly);
+    typedef Eigen::Matrix<typename DerivedN::Scalar, 1, 3> Normal;
+    const int nf = meshLayout.frontVertices;
+    N.topRows(nf).rowwise() = Normal(0, 0, 1);
+    N.middleRows(nf, nf).rowwise() = Normal(0, 0, -1);
+}
+
+template <typename Scalar>
+template <typename DerivedV, typename DerivedN>
+void BasicArmMeshBuilder<Scalar>::writeArcNormals(int arc, const Eigen::MatrixBase<DerivedV> &V, Eigen::MatrixBase<DerivedN> &N) const
+{
+    ARM_PROFILE_SCOPE(ArmStage::VertexAssembly);
+    typedef typename DerivedN::Scalar Output;
+    const int ns = meshLayout.sideVertices / 2, side = meshLayout.sideOffset;
+    const int first = meshLayout.arcOffset[arc];
+
+    //* The joint arcs bulge outwards, the fillet is concave: its outward normal points to its center.
+    const Scalar scale = (arc == 2 ? Scalar(-1) : Scalar(1)) / arcRadius[arc];
+    const Scalar cx = arcCenter[arc].x(), cy = arcCenter[arc].y();
+    for (int i = first; i < first + meshLayout.arcPoints[arc]; i++)
+    {
+        Output nx = Output((Scalar(V(i, 0)) - cx) * scale);
+        Output ny = Output((Scalar(V(i, 1)) - cy) * scale);
+        N(side + i, 0) = N(side + ns + i, 0) = nx;
+        N(side + i, 1) = N(side + ns + i, 1) = ny;
+        N(side + i, 2) = N(side + ns + i, 2) = Output(0);
+    }
+}
+
+template <typename Scalar>
+template <typename Emit>
+void BasicArmMeshBuilder<Scalar>::emitFrontFaces(Emit &&emit) const
+{
+    meshLayout.emitFrontFaces(emit);
+}
+
+template <typename Scalar>
+template <typename Emit>
+void BasicArmMeshBuilder<Scalar>::emitSideFaces(Emit &&emit) const
+{
+    meshLayout.emitSideFaces(emit);
+}
+
+template <typename Scalar>
+template <typename Emit>
+void BasicArmMeshBuilder<Scalar>::emitFaces(Emit &&emit) const
+{
+    meshLayout.emitFaces(emit);
+}
+
+//* FACES----------------------------------------------------------------------------------------------------------------------------------------------------------------
+template <typename Emit>
+void ArmMeshLayout::emitFrontFaces(Emit &&emit) const
+{
+    const int n0 = arcPoints[0], n1 = arcPoints[1], n2 = arcPoints[2], n3 = arcPoints[3];
+    const int a1 = arcOffset[1], a2 = arcOffset[2], a3 = arcOffset[3];
+
+    // Section 0
+    for (int i = 0; i < n0 - 1; i++)
+        emit(i, i + 1, indexP0);
+
+    // Section 1
+    emit(n0 - 1, a3 - 1, indexP0);
+    emit(indexP0, a3 - 1, a2 - 1);
+    emit(indexP0, a2 - 1, 0);
+
+    // Section 2, zip arc1 and the fillet arc together
+    for (int i = 1; i < std::max(n1, n2); i++)
+    {
+        if (i < n1)
+        {
+            if (i < n2)
+                emit(a1 + i - 1, a1 + i, a2 + i - 1);
+            else
+                emit(a1 + i - 1, a1 + i, a3 - 1);
+        }
+        if (i < n2)
+        {
+            if (i < n1)
+                emit(a2 + i, a2 + i - 1, a1 + i);
+            else
+                emit(a2 + i, a2 + i - 1, a2 - 1);
+        }
+    }
+
+    // Section 3
+    emit(a2, a3, indexP2);
+    emit(a2, indexP2, a1);
+    emit(a1, indexP2, a3 + n3 - 1);
+
+    // Section 4
+    for (int i = 0; i < n3 - 1; i++)
+        emit(a3 + i, a3 + i + 1, indexP2);
+}
+
+template <typename Emit>
+void ArmMeshLayout::emitSideFaces(Emit &&emit) const
+{
+    const int n0 = arcPoints[0], n1 = arcPoints[1], n2 = arcPoints[2], n3 = arcPoints[3];
+    const int a1 = arcOffset[1], a2 = arcOffset[2], a3 = arcOffset[3];
+    const int nf = frontVertices;
+
+    //* With split sides, front index i maps to its side copy and back index nf + i to the side back copy.
+    const int side = sideOffset, backShift = sideVertices / 2 - nf;
+    auto put = [&](int a, int b, int c)
+    {
+        if (sideVertices > 0)
+            emit(a < nf ? side + a : side + a + backShift, b < nf ? side + b : side + b + backShift, c < nf ? side + c : side + c + backShift);
+        else
+            emit(a, b, c);
+    };
+
+    // Section 0 side
+    for (int i = 0; i < n0 - 1; i++)
+        put(i, nf + i, nf + i + 1);
+    for (int i = 0; i < n0 - 1; i++)
+        put(i, nf + i + 1, i + 1);
+
+    // Section 4 side
+    for (int i = 0; i < n3 - 1; i++)
+        put(a3 + i, nf + a3 + i, nf + a3 + i + 1);
+    for (int i = 0; i < n3 - 1; i++)
+        put(a3 + i, nf + a3 + i + 1, a3 + i + 1);
+
+    // Section 1 side
+    put(n0 - 1, nf + a3 - 1, a3 - 1);
+    put(n0 - 1, nf + n0 - 1, nf + a3 - 1);
+    put(0, nf + a2 - 1, nf);
+    put(0, a2 - 1, nf + a2 - 1);
+
+    // Section 2 sides
+    for (int i = 0; i < n1 - 1; i++)
+        put(a1 + i, nf + a1 + i, nf + a1 + i + 1);
+    for (int i = 0; i < n1 - 1; i++)
+        put(a1 + i, nf + a1 + i + 1, a1 + i + 1);
+    for (int i = 0; i < n2 - 1; i++)
+        put(a2 + i, nf + a2 + i + 1, nf + a2 + i);
+    for (int i = 0; i < n2 - 1; i++)
+        put(a2 + i, a2 + i + 1, nf + a2 + i + 1);
+
+    // Section 3 side
+    put(a2, nf + a2, nf + a3);
+    put(a2, nf + a3, a3);
+    put(a1, nf + a3 + n3 - 1, nf + a1);
+    put(a1, a3 + n3 - 1, nf + a3 + n3 - 1);
+}
+
+template <typename Emit>
+void ArmMeshLayout::emitFaces(Emit &&emit) const
+{
+    const int nf = frontVertices;
+
+    // Front
+    emitFrontFaces(emit);
+    // Back, mirrored winding
+    emitFrontFaces([&](int a, int b, int c)
+                   { emit(a + nf, c + nf, b + nf); });
+    // Sides
+    emitSideFaces(emit);
+}
@@ -0,0 +1,186 @@
+//* Author: Zac Zhuo Zhang
+//* Least-recently-used cache of finished arm meshes, keyed by the parameters quantized to a tolerance.
+//* Two parameter tuples that round to the same multiples of the tolerance share one entry, so going back
+//* to a recently seen configuration (a scrubbed slider, a revisited sweep tuple) costs a lookup.
+//* Meshes are stored as ArmProfile (float outline, faces implied by the layout). The thickness is not part
+//* of the key: the profile views extrude to any thickness. The cache evicts the least recently used
+//* entries once their total size exceeds the memory bound.
+//* Thread-safe: lookups and inserts lock, entries are shared and immutable, so an evicted mesh stays
+//* valid for whoever still holds it.
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ArmParameters.h"
+#include "ArmMeshBuilder.h"
+#include "ArmProfile.h"
+
+class ArmMeshCache
+{
+public:
+    struct Statistics
+    {
+        unsigned long long hits = 0;
+        unsigned long long misses = 0;
+        unsigned long long evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+
+        double hitRate() const { return hits + misses > 0 ? (double)hits / (hits + misses) : 0; }
+    };
+
+    explicit ArmMeshCache(size_t maxBytes = size_t(256) << 20, double tolerance = 1e-6);
+
+    //* Null on a miss. splitSides tells which builder layout is asked for, both are cached separately.
+    std::shared_ptr<const ArmProfile> find(const ArmParameters &p, bool splitSides = false);
+    void insert(const ArmParameters &p, std::shared_ptr<const ArmProfile> profile);
+
+    //* find(), or build the profile with builder and insert.
+    std::shared_ptr<const ArmProfile> findOrBuild(const ArmParameters &p, ArmMeshBuilder &builder);
+
+    Statistics statistics() const;
+    void clear();
+
+    size_t maxBytes() const { return memoryBound; }
+    double tolerance() const { return step; }
+
+private:
+    //* Every parameter but the thickness (the last one).
+    static const int KeyParameters = ArmParameters::Count - 1;
+
+    struct Key
+    {
+        long long q[KeyParameters];
+        bool splitSides;
+
+        bool operator==(const Key &other) const
+        {
+            for (int k = 0; k < KeyParameters; k++)
+                if (q[k] != other.q[k])
+                    return false;
+            return splitSides == other.splitSides;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        {
+            uint64_t h = key.splitSides ? 0x9e3779b97f4a7c15ull : 0;
+            for (int k = 0; k < KeyParameters; k++)
+                h = (h ^ (uint64_t)key.q[k]) * 0x100000001b3ull;
+            return (size_t)(h ^ (h >> 32));
+        }
+    };
+
+    typedef std::list<std::pair<Key, std::shared_ptr<const ArmProfile>>> Entries;
+
+    Key makeKey(const ArmParameters &p, bool splitSides) const;
+    void evict();
+
+    size_t memoryBound;
+    double step;
+
+    mutable std::mutex mutex;
+    Entries entries; // most recently used first
+    std::unordered_map<Key, Entries::iterator, KeyHash> index;
+    Statistics stats;
+};
+
+inline ArmMeshCache::ArmMeshCache(size_t maxBytes, double tolerance) : memoryBound(maxBytes), step(tolerance)
+{
+}
+
+inline ArmMeshCache::Key ArmMeshCache::makeKey(const ArmParameters &p, bool splitSides) const
+{
+    Key key;
+    for (int k = 0; k < KeyParameters; k++)
+        key.q[k] = std::llround(p[k] / step);
+    key.splitSides = splitSides;
+    return key;
+}
+
+inline std::shared_ptr<const ArmProfile> ArmMeshCache::find(const ArmParameters &p, bool splitSides)
+{
+    Key key = makeKey(p, splitSides);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found == index.end())
+    {
+        stats.misses++;
+        return nullptr;
+    }
+    stats.hits++;
+    entries.splice(entries.begin(), entries, found->second);
+    return found->second->second;
+}
+
+inline void ArmMeshCache::insert(const ArmParameters &p, std::shared_ptr<const ArmProfile> profile)
+{
+    //* A profile bigger than the whole cache would only evict everything else.
+    if (!profile || profile->bytes() > memoryBound)
+        return;
+
+    Key key = makeKey(p, profile->layout().sideVertices > 0);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found != index.end())
+    {
+        //* Another thread built the same configuration meanwhile: keep one.
+        stats.bytes -= found->second->second->bytes();
+        entries.erase(found->second);
+        index.erase(found);
+    }
+    stats.bytes += profile->bytes();
+    entries.emplace_front(key, std::move(profile));
+    index[key] = entries.begin();
+    evict();
+    stats.entries = entries.size();
+}
+
+inline void ArmMeshCache::evict()
+{
+    while (stats.bytes > memoryBound && !entries.empty())
+    {
+        stats.bytes -= entries.back().second->bytes();
+        index.erase(entries.back().first);
+        entries.pop_back();
+        stats.evictions++;
+    }
+}
+
+inline std::shared_ptr<const ArmProfile> ArmMeshCache::findOrBuild(const ArmParameters &p, ArmMeshBuilder &builder)
+{
+    std::shared_ptr<const ArmProfile> profile = find(p, builder.hasSplitSides());
+    if (profile)
+        return profile;
+
+    std::shared_ptr<ArmProfile> built = std::make_shared<ArmProfile>();
+    built->build(builder, p);
+    insert(p, built);
+    return built;
+}
+
+inline ArmMeshCache::Statistics ArmMeshCache::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+inline void ArmMeshCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    stats.entries = 0;
+    stats.bytes = 0;
+}
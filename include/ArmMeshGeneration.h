@@ -0,0 +1,39 @@
+//* Author: Zac Zhuo Zhang
+//* Generate the two-link arm mesh (P0 -> P1 -> P2) from its ten parameters.
+//* The 2D profile is built from the joint circles, their tangent lines and the fillet arc,
+//* then extruded along -Z by the thickness.
+//* Headless: only depends on Eigen, so it can be used without the viewer.
+//* Convenience wrapper around ArmMeshBuilder, which returns fresh matrices on every call;
+//* use ArmMeshBuilder directly to reuse the buffers between builds.
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <utility>
+
+#include "ArmParameters.h"
+#include "ArmMeshBuilder.h"
+
+inline std::pair<Eigen::MatrixXd, Eigen::MatrixXi> ArmMeshGeneration(const ArmParameters &p)
+{
+    ArmMeshBuilder builder;
+    std::pair<Eigen::MatrixXd, Eigen::MatrixXi> VF;
+    builder.build(p, VF.first, VF.second);
+    return VF;
+}
+
+inline std::pair<Eigen::MatrixXd, Eigen::MatrixXi> ArmMeshGeneration(double R0, double R1, double R2, double Rad0, double Rad1, double length0, double length1, double d, double MeshMaxDistance, double thickness)
+{
+    ArmParameters p;
+    p.R0 = R0;
+    p.R1 = R1;
+    p.R2 = R2;
+    p.Rad0 = Rad0;
+    p.Rad1 = Rad1;
+    p.length0 = length0;
+    p.length1 = length1;
+    p.d = d;
+    p.MeshMaxDistance = MeshMaxDistance;
+    p.thickness = thickness;
+    return ArmMeshGeneration(p);
+}
@@ -0,0 +1,22 @@
+//* Author: Zac Zhuo Zhang
+//* Receiver of a streamed mesh, see ArmMeshBuilder::stream.
+//* The generator calls begin() with the final counts, then vertex() for every vertex in index order,
+//* then face() for every triangle in face order, then end().
+//* face() also passes the three corner positions, so a sink that needs them (e.g. STL) does not have to
+//* keep the vertices.
+
+#pragma once
+
+#include <Eigen/Dense>
+
+class ArmMeshSink
+{
+public:
+    virtual ~ArmMeshSink() = default;
+
+    virtual void begin(int vertices, int faces) = 0;
+    virtual void vertex(double x, double y, double z) = 0;
+    virtual void face(int a, int b, int c, const Eigen::Vector3d &pa, const Eigen::Vector3d &pb, const Eigen::Vector3d &pc) = 0;
+    //* Returns false if the sink failed (e.g. a write error).
+    virtual bool end() = 0;
+};
@@ -0,0 +1,169 @@
+//* Author: Zac Zhuo Zhang
+//* Binary PLY and STL writers for ArmMeshBuilder::stream.
+//* Both write through a fixed-size buffer, so a mesh of any size goes to disk in large sequential writes
+//* without ever being held in memory. Positions are written as float, PLY indices as int32.
+//* Binary PLY and STL are little endian, the writers assume a little-endian host (x86, ARM).
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ArmMeshSink.h"
+
+class BufferedFileWriter
+{
+public:
+    //* The buffer is only allocated by open().
+    explicit BufferedFileWriter(size_t capacity = size_t(1) << 20) : capacity(capacity) {}
+    ~BufferedFileWriter() { close(); }
+
+    BufferedFileWriter(const BufferedFileWriter &) = delete;
+    BufferedFileWriter &operator=(const BufferedFileWriter &) = delete;
+
+    bool open(const std::string &path);
+    void write(const void *data, size_t size);
+    template <typename T>
+    void write(const T &value) { write(&value, sizeof(T)); }
+    //* Flushes and closes, false if anything failed since open().
+    bool close();
+
+private:
+    void flush();
+
+    std::FILE *file = nullptr;
+    size_t capacity;
+    std::vector<char> buffer;
+    size_t used = 0;
+    bool failed = false;
+};
+
+class PlyMeshWriter : public ArmMeshSink
+{
+public:
+    explicit PlyMeshWriter(const std::string &path) : path(path) {}
+
+    void begin(int vertices, int faces) override;
+    void vertex(double x, double y, double z) override;
+    void face(int a, int b, int c, const Eigen::Vector3d &pa, const Eigen::Vector3d &pb, const Eigen::Vector3d &pc) override;
+    bool end() override { return out.close(); }
+
+private:
+    std::string path;
+    BufferedFileWriter out;
+};
+
+class StlMeshWriter : public ArmMeshSink
+{
+public:
+    explicit StlMeshWriter(const std::string &path) : path(path) {}
+
+    void begin(int vertices, int faces) override;
+    void vertex(double, double, double) override {}
+    void face(int a, int b, int c, const Eigen::Vector3d &pa, const Eigen::Vector3d &pb, const Eigen::Vector3d &pc) override;
+    bool end() override { return out.close(); }
+
+private:
+    std::string path;
+    BufferedFileWriter out;
+};
+
+inline bool BufferedFileWriter::open(const std::string &path)
+{
+    close();
+    failed = false;
+    buffer.resize(capacity);
+    file = std::fopen(path.c_str(), "wb");
+    failed = file == nullptr;
+    return !failed;
+}
+
+inline void BufferedFileWriter::write(const void *data, size_t size)
+{
+    if (!file)
+        return;
+    if (used + size > buffer.size())
+        flush();
+    if (size > buffer.size())
+    {
+        failed |= std::fwrite(data, 1, size, file) != size;
+        return;
+    }
+    std::memcpy(buffer.data() + used, data, size);
+    used += size;
+}
+
+inline void BufferedFileWriter::flush()
+{
+    if (file && used > 0)
+        failed |= std::fwrite(buffer.data(), 1, used, file) != used;
+    used = 0;
+}
+
+inline bool BufferedFileWriter::close()
+{
+    if (file)
+    {
+        flush();
+        failed |= std::fclose(file) != 0;
+        file = nullptr;
+    }
+    return !failed;
+}
+
+inline void PlyMeshWriter::begin(int vertices, int faces)
+{
+    out.open(path);
+    std::string header = "ply\nformat binary_little_endian 1.0\ncomment arm mesh\n"
+                         "element vertex " + std::to_string(vertices) + "\n"
+                         "property float x\nproperty float y\nproperty float z\n"
+                         "element face " + std::to_string(faces) + "\n"
+                         "property list uchar int vertex_indices\nend_header\n";
+    out.write(header.data(), header.size());
+}
+
+inline void PlyMeshWriter::vertex(double x, double y, double z)
+{
+    float position[3] = {(float)x, (float)y, (float)z};
+    out.write(position, sizeof(position));
+}
+
+inline void PlyMeshWriter::face(int a, int b, int c, const Eigen::Vector3d &, const Eigen::Vector3d &, const Eigen::Vector3d &)
+{
+    //* 1 + 12 bytes, packed
+    char record[13];
+    record[0] = 3;
+    int32_t indices[3] = {a, b, c};
+    std::memcpy(record + 1, indices, sizeof(indices));
+    out.write(record, sizeof(record));
+}
+
+inline void StlMeshWriter::begin(int, int faces)
+{
+    out.open(path);
+    char header[80] = {};
+    std::strncpy(header, "arm mesh", sizeof(header));
+    out.write(header, sizeof(header));
+    out.write((uint32_t)faces);
+}
+
+inline void StlMeshWriter::face(int, int, int, const Eigen::Vector3d &pa, const Eigen::Vector3d &pb, const Eigen::Vector3d &pc)
+{
+    Eigen::Vector3d normal = (pb - pa).cross(pc - pa);
+    double length = normal.norm();
+    if (length > 0)
+        normal /= length;
+
+    //* normal, three corners, attribute byte count: 50 bytes, packed
+    char record[50];
+    float values[12] = {(float)normal.x(), (float)normal.y(), (float)normal.z(),
+                        (float)pa.x(), (float)pa.y(), (float)pa.z(),
+                        (float)pb.x(), (float)pb.y(), (float)pb.z(),
+                        (float)pc.x(), (float)pc.y(), (float)pc.z()};
+    std::memcpy(record, values, sizeof(values));
+    record[48] = record[49] = 0;
+    out.write(record, sizeof(record));
+}
@@ -0,0 +1,193 @@
+//* Author: Zac Zhuo Zhang
+//* Stateful arm model that only recomputes what a parameter change affects.
+//*
+//* Dependencies of the profile on the parameters:
+//*   link 0 (P1, tangents P0-P1)   <- R0, R1, Rad0, length0
+//*   link 1 (P2, tangents P1-P2)   <- R1, R2, Rad0, length0 (through P1), Rad1, length1
+//*   fillet                        <- link 0, link 1, d
+//*   arc0 <- link 0, arc1 <- link 0 + link 1, arc2 <- fillet, arc3 <- link 1, all arcs <- MeshMaxDistance
+//*   back vertices z               <- thickness
+//* Only dirty arcs are re-divided, and only their back copies are rewritten.
+//* The faces are only rewritten when an arc point count changes, which MeshMaxDistance usually does,
+//* but any parameter that changes an arc's angle can as well.
+//* With normals, the mesh has split side vertices (see ArmMeshBuilder) and only dirty arcs get new normals.
+
+#pragma once
+
+#include <Eigen/Dense>
+
+#include "ArmParameters.h"
+#include "ArmMeshBuilder.h"
+#include "ArmProfile.h"
+
+class ArmModel
+{
+public:
+    //* What update() changed in V and F.
+    enum class Change
+    {
+        None,
+        Vertices, // same F, new vertex positions
+        Topology  // new F (and V size)
+    };
+
+    explicit ArmModel(const ArmParameters &p = ArmParameters(), bool normals = false);
+
+    const ArmParameters &parameters() const { return params; }
+    void set(int parameter, double value);
+    void setParameters(const ArmParameters &p);
+
+    //* Bring V and F up to date with the parameters.
+    Change update();
+
+    const Eigen::MatrixXd &V() const { return vertices; }
+    const Eigen::MatrixXi &F() const { return faces; }
+    //* Per-vertex normals, empty unless constructed with normals.
+    const Eigen::MatrixXd &N() const { return normals; }
+    const ArmMeshLayout &layout() const { return builder.layout(); }
+    //* The current mesh as a profile (valid after update()).
+    void writeProfile(ArmProfile &profile) const { profile.assign(builder, vertices, params.thickness); }
+
+private:
+    enum Dirty : unsigned
+    {
+        Link0 = 1 << 0,
+        Link1 = 1 << 1,
+        Fillet = 1 << 2,
+        Arcs = 1 << 3, // MeshMaxDistance: every arc point count may change
+        Thickness = 1 << 4,
+        Everything = Link0 | Link1 | Fillet | Arcs | Thickness
+    };
+
+    static unsigned dependents(int parameter);
+
+    ArmParameters params;
+    unsigned dirty = Everything;
+    bool initialized = false;
+
+    ArmMeshBuilder builder;
+    Eigen::MatrixXd vertices;
+    Eigen::MatrixXi faces;
+    Eigen::MatrixXd normals;
+};
+
+inline ArmModel::ArmModel(const ArmParameters &p, bool normals) : params(p), builder(normals)
+{
+}
+
+inline unsigned ArmModel::dependents(int parameter)
+{
+    switch (parameter)
+    {
+    case 0: // R0
+        return Link0;
+    case 1: // R1
+        return Link0 | Link1;
+    case 2: // R2
+        return Link1;
+    case 3: // Rad0
+    case 5: // length0
+        return Link0 | Link1;
+    case 4: // Rad1
+    case 6: // length1
+        return Link1;
+    case 7: // d
+        return Fillet;
+    case 8: // MeshMaxDistance
+        return Arcs;
+    default: // thickness
+        return Thickness;
+    }
+}
+
+inline void ArmModel::set(int parameter, double value)
+{
+    if (params[parameter] == value)
+        return;
+    params[parameter] = value;
+    dirty |= dependents(parameter);
+}
+
+inline void ArmModel::setParameters(const ArmParameters &p)
+{
+    for (int k = 0; k < ArmParameters::Count; k++)
+        set(k, p[k]);
+}
+
+inline ArmModel::Change ArmModel::update()
+{
+    if (!initialized)
+    {
+        if (builder.hasSplitSides())
+            builder.build(params, vertices, faces, normals);
+        else
+            builder.build(params, vertices, faces);
+        initialized = true;
+        dirty = 0;
+        return Change::Topology;
+    }
+    if (dirty == 0)
+        return Change::None;
+
+    //* Propagate to the arcs: arc0 <- link 0, arc1 <- both links, arc2 <- fillet, arc3 <- link 1.
+    if (dirty & (Link0 | Link1))
+        dirty |= Fillet;
+    bool arcDirty[4] = {
+        (dirty & (Link0 | Arcs)) != 0,
+        (dirty & (Link0 | Link1 | Arcs)) != 0,
+        (dirty & (Fillet | Arcs)) != 0,
+        (dirty & (Link1 | Arcs)) != 0};
+
+    if (dirty & Link0)
+        builder.solveLink0(params);
+    if (dirty & Link1)
+        builder.solveLink1(params);
+    if (dirty & Fillet)
+        builder.solveFillet(params);
+
+    if (arcDirty[0] || arcDirty[1] || arcDirty[2] || arcDirty[3])
+    {
+        if (builder.layoutArcs(params.MeshMaxDistance))
+        {
+            //* Arc point counts changed: offsets moved, rewrite everything.
+            const ArmMeshLayout &layout = builder.layout();
+            vertices.resize(layout.vertices, 3);
+            faces.resize(layout.faces, 3);
+            builder.writeFrontVertices(vertices);
+            builder.writeBackVertices(vertices, params.thickness);
+            builder.writeFaces(faces);
+            if (builder.hasSplitSides())
+            {
+                normals.resize(layout.vertices, 3);
+                builder.writeNormals(vertices, normals);
+            }
+            dirty = 0;
+            ARM_PROFILE_COMMIT(layout.vertices, layout.faces);
+            return Change::Topology;
+        }
+
+        const ArmMeshLayout &layout = builder.layout();
+        for (int k = 0; k < 4; k++)
+        {
+            if (!arcDirty[k])
+                continue;
+            builder.writeArc(k, vertices);
+            builder.writeBackVertices(vertices, params.thickness, layout.arcOffset[k], layout.arcPoints[k]);
+            if (builder.hasSplitSides())
+                builder.writeArcNormals(k, vertices, normals);
+        }
+        if (dirty & Link1)
+        {
+            //* P2 moved
+            builder.writeCenters(vertices);
+            builder.writeBackVertices(vertices, params.thickness, layout.indexP0, 2);
+        }
+    }
+
+    if (dirty & Thickness)
+        builder.writeThickness(vertices, params.thickness);
+
+    dirty = 0;
+    ARM_PROFILE_COMMIT(builder.layout().vertices, builder.layout().faces);
+    return Change::Vertices;
+}
@@ -0,0 +1,48 @@
+//* Author: Zac Zhuo Zhang
+//* The parameters of the two-link arm model.
+
+#pragma once
+
+#include <cmath>
+
+//* The ten arm parameters, in the order of the ArmMeshGeneration arguments.
+//* Default values (m) are the ones the viewer starts with.
+struct ArmParameters
+{
+    double R0 = 0.300;
+    double R1 = 0.200;
+    double R2 = 0.200;
+    double Rad0 = M_PI / 6;
+    double Rad1 = -M_PI / 6;
+    double length0 = 1.200;
+    double length1 = 1.700;
+    double d = 0.200;
+    double MeshMaxDistance = 0.050; // The resolution of the mesh
+    double thickness = 0.50;
+
+    static const int Count = 10;
+    static const int MeshMaxDistanceIndex = 8;
+    //* The arc point counts follow from MeshMaxDistance, it must be positive and finite.
+    static bool validMeshMaxDistance(double value) { return std::isfinite(value) && value > 0; }
+    static const char *name(int i);
+    double &operator[](int i);
+    double operator[](int i) const;
+};
+
+inline const char *ArmParameters::name(int i)
+{
+    static const char *names[Count] = {"R0", "R1", "R2", "Rad0", "Rad1", "length0", "length1", "d", "MeshMaxDistance", "thickness"};
+    return names[i];
+}
+
+inline double &ArmParameters::operator[](int i)
+{
+    static double ArmParameters::*const members[Count] = {&ArmParameters::R0, &ArmParameters::R1, &ArmParameters::R2, &ArmParameters::Rad0, &ArmParameters::Rad1,
+                                                          &ArmParameters::length0, &ArmParameters::length1, &ArmParameters::d, &ArmParameters::MeshMaxDistance, &ArmParameters::thickness};
+    return this->*members[i];
+}
+
+inline double ArmParameters::operator[](int i) const
+{
+    return (*const_cast<ArmParameters *>(this))[i];
+}
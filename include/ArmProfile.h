@@ -0,0 +1,219 @@
+//* Author: Zac Zhuo Zhang
+//* The arm as what it is: a 2D profile extruded along -Z.
+//* ArmProfile keeps the front outline (x, y as float), the four arc circles and angles, the layout and the thickness.
+//* The cap triangulation and the side walls follow from the layout alone (ArmMeshLayout::emitFaces),
+//* and the back and side vertices are the outline at z = -thickness, so nothing else is stored:
+//* about 8 bytes per front vertex against 72 for float V plus int F of the full mesh.
+//* The views produce the same faces as ArmMeshBuilder, for any thickness, so a thickness change never needs
+//* a rebuild. Positions are the float outline: each x and y is within half a float ulp (2^-24 relative,
+//* about 6e-8) of the builder's. Normals come from the double circles and angles, not the outline, and
+//* match the builder's to double rounding.
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <vector>
+
+#include "ArmParameters.h"
+#include "ArmMeshBuilder.h"
+#include "ArmMeshSink.h"
+
+class ArmProfile
+{
+public:
+    double thickness = 0;
+
+    //* Solve p with builder and keep the outline.
+    void build(ArmMeshBuilder &builder, const ArmParameters &p);
+    //* Keep the outline of a builder after prepare(), with the front vertices already written to V.
+    void assign(const ArmMeshBuilder &builder, const Eigen::MatrixXd &V, double thickness);
+
+    const ArmMeshLayout &layout() const { return meshLayout; }
+    int vertices() const { return meshLayout.vertices; }
+    int faces() const { return meshLayout.faces; }
+    size_t bytes() const { return sizeof(ArmProfile) + outline.size() * sizeof(float); }
+    bool finite() const;
+
+    //* Views------------------------------------------------------------------------------------------------------------------------------------------------------------------
+    //* V must have vertices() rows.
+    void writeVertices(double thickness, Eigen::MatrixXd &V) const;
+    //* Only the z of the back (and side back) vertices.
+    void writeThickness(double thickness, Eigen::MatrixXd &V) const;
+    //* Per-vertex normals, for profiles of a split-sides builder. N must have vertices() rows.
+    void writeNormals(Eigen::MatrixXd &N) const;
+    void writeFaces(Eigen::MatrixXi &F) const;
+    template <typename Emit>
+    void emitFaces(Emit &&emit) const { meshLayout.emitFaces(emit); }
+
+    //* Resize and fill V, F (and N when it is not null and the profile has split sides).
+    void toMatrices(double thickness, Eigen::MatrixXd &V, Eigen::MatrixXi &F, Eigen::MatrixXd *N = nullptr) const;
+    void toMatrices(Eigen::MatrixXd &V, Eigen::MatrixXi &F, Eigen::MatrixXd *N = nullptr) const { toMatrices(thickness, V, F, N); }
+
+    //* Same order as ArmMeshBuilder::stream. Returns sink.end().
+    bool stream(double thickness, ArmMeshSink &sink) const;
+    bool stream(ArmMeshSink &sink) const { return stream(thickness, sink); }
+
+private:
+    void assignCircles(const ArmMeshBuilder &builder, double thickness);
+
+    //* Front index of vertex i of the full layout, and whether it is on the back.
+    int frontIndex(int i, bool &back) const;
+
+    std::vector<float> outline; // x, y per front vertex
+    double circleCenter[4][2];
+    double circleRadius[4];
+    double arcStartAngle[4], arcEndAngle[4], arcStepAngle[4];
+    ArmMeshLayout meshLayout;
+};
+
+inline void ArmProfile::build(ArmMeshBuilder &builder, const ArmParameters &p)
+{
+    builder.prepare(p);
+    assignCircles(builder, p.thickness);
+
+    //* The builder writes the float outline itself, no double copy in between.
+    outline.resize(2 * meshLayout.frontVertices);
+    Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 2, Eigen::RowMajor>> front(outline.data(), meshLayout.frontVertices, 2);
+    builder.writeFrontVertices(front);
+    ARM_PROFILE_COMMIT(meshLayout.vertices, meshLayout.faces);
+}
+
+inline void ArmProfile::assign(const ArmMeshBuilder &builder, const Eigen::MatrixXd &V, double thickness)
+{
+    assignCircles(builder, thickness);
+
+    outline.resize(2 * meshLayout.frontVertices);
+    for (int i = 0; i < meshLayout.frontVertices; i++)
+    {
+        outline[2 * i] = (float)V(i, 0);
+        outline[2 * i + 1] = (float)V(i, 1);
+    }
+}
+
+inline void ArmProfile::assignCircles(const ArmMeshBuilder &builder, double thickness)
+{
+    this->thickness = thickness;
+    meshLayout = builder.layout();
+    for (int k = 0; k < 4; k++)
+    {
+        circleCenter[k][0] = builder.circleCenter(k).x();
+        circleCenter[k][1] = builder.circleCenter(k).y();
+        circleRadius[k] = builder.circleRadius(k);
+        arcStartAngle[k] = std::atan2(builder.arcFirstPoint(k).y() - circleCenter[k][1], builder.arcFirstPoint(k).x() - circleCenter[k][0]);
+        arcEndAngle[k] = std::atan2(builder.arcLastPoint(k).y() - circleCenter[k][1], builder.arcLastPoint(k).x() - circleCenter[k][0]);
+        arcStepAngle[k] = builder.arcStep(k);
+    }
+}
+
+inline bool ArmProfile::finite() const
+{
+    for (float value : outline)
+        if (!std::isfinite(value))
+            return false;
+    return true;
+}
+
+inline int ArmProfile::frontIndex(int i, bool &back) const
+{
+    const int nf = meshLayout.frontVertices, ns = meshLayout.sideVertices / 2;
+    back = false;
+    if (ns > 0 && i >= meshLayout.sideOffset)
+    {
+        i -= meshLayout.sideOffset;
+        back = i >= ns;
+        return back ? i - ns : i;
+    }
+    if (i >= nf)
+    {
+        back = true;
+        return i - nf;
+    }
+    return i;
+}
+
+inline void ArmProfile::writeVertices(double thickness, Eigen::MatrixXd &V) const
+{
+    for (int i = 0; i < meshLayout.vertices; i++)
+    {
+        bool back;
+        int f = frontIndex(i, back);
+        V(i, 0) = outline[2 * f];
+        V(i, 1) = outline[2 * f + 1];
+        V(i, 2) = back ? -thickness : 0;
+    }
+}
+
+inline void ArmProfile::writeThickness(double thickness, Eigen::MatrixXd &V) const
+{
+    V.col(2).segment(meshLayout.frontVertices, meshLayout.frontVertices).setConstant(-thickness);
+    V.col(2).segment(meshLayout.sideOffset + meshLayout.sideVertices / 2, meshLayout.sideVertices / 2).setConstant(-thickness);
+}
+
+inline void ArmProfile::writeNormals(Eigen::MatrixXd &N) const
+{
+    const int nf = meshLayout.frontVertices, ns = meshLayout.sideVertices / 2, side = meshLayout.sideOffset;
+    N.topRows(nf).rowwise() = Eigen::RowVector3d(0, 0, 1);
+    N.middleRows(nf, nf).rowwise() = Eigen::RowVector3d(0, 0, -1);
+
+    //* As ArmMeshBuilder::writeArcNormals, the fillet (arc 2) is concave. Point j of an arc lies at the start
+    //* angle plus j steps, the last one at the end angle, as the divider places them.
+    for (int k = 0; k < 4 && ns > 0; k++)
+    {
+        const double sign = k == 2 ? -1.0 : 1.0;
+        const int first = meshLayout.arcOffset[k], last = first + meshLayout.arcPoints[k] - 1;
+        for (int i = first; i <= last; i++)
+        {
+            double angle = i == last ? arcEndAngle[k] : arcStartAngle[k] + (i - first) * arcStepAngle[k];
+            double nx = sign * std::cos(angle);
+            double ny = sign * std::sin(angle);
+            N(side + i, 0) = N(side + ns + i, 0) = nx;
+            N(side + i, 1) = N(side + ns + i, 1) = ny;
+            N(side + i, 2) = N(side + ns + i, 2) = 0;
+        }
+    }
+}
+
+inline void ArmProfile::writeFaces(Eigen::MatrixXi &F) const
+{
+    int row = 0;
+    meshLayout.emitFaces([&](int a, int b, int c)
+                         {
+        F(row, 0) = a;
+        F(row, 1) = b;
+        F(row, 2) = c;
+        row++; });
+}
+
+inline void ArmProfile::toMatrices(double thickness, Eigen::MatrixXd &V, Eigen::MatrixXi &F, Eigen::MatrixXd *N) const
+{
+    V.resize(meshLayout.vertices, 3);
+    F.resize(meshLayout.faces, 3);
+    writeVertices(thickness, V);
+    writeFaces(F);
+    if (N && meshLayout.sideVertices > 0)
+    {
+        N->resize(meshLayout.vertices, 3);
+        writeNormals(*N);
+    }
+}
+
+inline bool ArmProfile::stream(double thickness, ArmMeshSink &sink) const
+{
+    auto position = [&](int i)
+    {
+        bool back;
+        int f = frontIndex(i, back);
+        return Eigen::Vector3d(outline[2 * f], outline[2 * f + 1], back ? -thickness : 0);
+    };
+
+    sink.begin(meshLayout.vertices, meshLayout.faces);
+    for (int i = 0; i < meshLayout.vertices; i++)
+    {
+        Eigen::Vector3d v = position(i);
+        sink.vertex(v.x(), v.y(), v.z());
+    }
+    meshLayout.emitFaces([&](int a, int b, int c)
+                         { sink.face(a, b, c, position(a), position(b), position(c)); });
+    return sink.end();
+}
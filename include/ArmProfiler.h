@@ -0,0 +1,220 @@
+//* Author: Zac Zhuo Zhang
+//* Per-stage timing of the mesh generation and the viewer upload.
+//* Build with ARM_PROFILING defined (CMake option ARM_PROFILING) to enable it;
+//* otherwise ARM_PROFILE_SCOPE and ARM_PROFILE_COMMIT expand to nothing.
+//*
+//* ARM_PROFILE_SCOPE(stage) adds the time of the enclosing scope to the calling thread's running totals.
+//* ARM_PROFILE_COMMIT(vertices, faces) turns those totals into one sample per touched stage, so a stage
+//* called several times in one build (e.g. four arcs) counts as one sample.
+//* Totals are per thread, so the thread that runs the scopes commits them: a pool task that builds a whole
+//* mesh commits its own sample, and a build split across pool tasks is timed around its parallel loops by
+//* the calling thread (ArmChainBuilder), never inside the tasks.
+//* The last samples of every stage give rolling p50/p99, in fixed memory. Full samples are only recorded
+//* while a capture is active (setCapture(true)), those can be written as CSV.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class ArmStage
+{
+    TangentSolve,   // tangent lines and fillet circle
+    ArcDivision,    // arc point counts and tessellation
+    VertexAssembly, // centers and back vertices
+    FaceAssembly,   // all triangles
+    Concatenation,  // copying the finished mesh into output / hand-off buffers
+    Upload,         // viewer set_mesh / set_vertices / set_normals
+    Count
+};
+
+class ArmProfiler
+{
+public:
+    struct Sample
+    {
+        ArmStage stage;
+        double milliseconds;
+        int vertices;
+        int faces;
+    };
+
+    struct Statistics
+    {
+        double p50 = 0; // ms
+        double p99 = 0; // ms
+        int samples = 0;
+    };
+
+    static const int window = 256; // samples per stage kept for the rolling statistics
+
+    static ArmProfiler &instance()
+    {
+        static ArmProfiler profiler;
+        return profiler;
+    }
+
+    static const char *stageName(ArmStage stage)
+    {
+        static const char *names[] = {"TangentSolve", "ArcDivision", "VertexAssembly", "FaceAssembly", "Concatenation", "Upload"};
+        return names[(int)stage];
+    }
+
+    void add(ArmStage stage, long long nanoseconds) { pending()[(int)stage] += nanoseconds; }
+    void commit(int vertices, int faces);
+
+    Statistics statistics(ArmStage stage) const;
+    int lastVertices() const;
+    int lastFaces() const;
+
+    //* Starting a capture drops the samples of the previous one; stopping keeps them for writeCsv.
+    void setCapture(bool on);
+    bool capturing() const;
+
+    void writeCsv(std::ostream &out) const;
+    bool writeCsv(const std::string &path) const;
+    void clear();
+
+private:
+    //* Running totals of the calling thread, -1 for untouched stages.
+    static long long *pending()
+    {
+        thread_local long long totals[(int)ArmStage::Count] = {-1, -1, -1, -1, -1, -1};
+        return totals;
+    }
+
+    mutable std::mutex mutex;
+    bool capture = false;
+    std::vector<Sample> samples;
+    std::vector<double> recent[(int)ArmStage::Count];
+    int recentNext[(int)ArmStage::Count] = {};
+    int vertices = 0;
+    int faces = 0;
+};
+
+class ArmProfileScope
+{
+public:
+    explicit ArmProfileScope(ArmStage stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+    ~ArmProfileScope()
+    {
+        ArmProfiler::instance().add(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    ArmStage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef ARM_PROFILING
+#define ARM_PROFILE_CONCAT_(a, b) a##b
+#define ARM_PROFILE_CONCAT(a, b) ARM_PROFILE_CONCAT_(a, b)
+#define ARM_PROFILE_SCOPE(stage) ArmProfileScope ARM_PROFILE_CONCAT(armProfileScope, __LINE__)(stage)
+#define ARM_PROFILE_COMMIT(vertices, faces) ArmProfiler::instance().commit(vertices, faces)
+#else
+#define ARM_PROFILE_SCOPE(stage)
+#define ARM_PROFILE_COMMIT(vertices, faces)
+#endif
+
+inline void ArmProfiler::commit(int vertexCount, int faceCount)
+{
+    long long *totals = pending();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int k = 0; k < (int)ArmStage::Count; k++)
+    {
+        if (totals[k] < 0)
+            continue;
+
+        //* The -1 marker means "not called", so undo it before converting.
+        double milliseconds = (totals[k] + 1) * 1e-6;
+        totals[k] = -1;
+        if (capture)
+            samples.push_back({(ArmStage)k, milliseconds, vertexCount, faceCount});
+
+        if ((int)recent[k].size() < window)
+            recent[k].push_back(milliseconds);
+        else
+            recent[k][recentNext[k]] = milliseconds;
+        recentNext[k] = (recentNext[k] + 1) % window;
+    }
+    vertices = vertexCount;
+    faces = faceCount;
+}
+
+inline ArmProfiler::Statistics ArmProfiler::statistics(ArmStage stage) const
+{
+    std::vector<double> sorted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sorted = recent[(int)stage];
+    }
+
+    Statistics result;
+    result.samples = (int)sorted.size();
+    if (sorted.empty())
+        return result;
+    std::sort(sorted.begin(), sorted.end());
+    result.p50 = sorted[(sorted.size() - 1) / 2];
+    result.p99 = sorted[(sorted.size() - 1) * 99 / 100];
+    return result;
+}
+
+inline int ArmProfiler::lastVertices() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return vertices;
+}
+
+inline int ArmProfiler::lastFaces() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return faces;
+}
+
+inline void ArmProfiler::setCapture(bool on)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (on && !capture)
+        samples.clear();
+    capture = on;
+}
+
+inline bool ArmProfiler::capturing() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return capture;
+}
+
+inline void ArmProfiler::writeCsv(std::ostream &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "sample,stage,milliseconds,vertices,faces\n";
+    for (size_t i = 0; i < samples.size(); i++)
+        out << i << ',' << stageName(samples[i].stage) << ',' << samples[i].milliseconds << ',' << samples[i].vertices << ',' << samples[i].faces << '\n';
+}
+
+inline bool ArmProfiler::writeCsv(const std::string &path) const
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    writeCsv(out);
+    return true;
+}
+
+inline void ArmProfiler::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    samples.clear();
+    for (int k = 0; k < (int)ArmStage::Count; k++)
+    {
+        recent[k].clear();
+        recentNext[k] = 0;
+    }
+    vertices = faces = 0;
+}
@@ -0,0 +1,365 @@
+//* Author: Zac Zhuo Zhang
+//* Baked arm animations: a keyframed Rad0/Rad1 trajectory meshed for every frame, written to one file
+//* that holds a single index buffer and the vertex positions of every frame.
+//*
+//* The arc point counts depend on the joint angles, so the meshes of a moving arm do not share a topology
+//* by themselves. The baker first counts the points every frame would need at MeshMaxDistance and keeps the
+//* maximum per arc, then meshes every frame with exactly those counts (uniform steps, so no segment is
+//* longer than MeshMaxDistance in any frame). Both passes run frame-parallel on a WorkStealingPool.
+//* Positions are converted to float and written in chunks of chunkFrames frames, so memory does not grow
+//* with the length of the animation.
+//*
+//* File layout (little endian, like ArmMeshWriters.h):
+//*   "ARMTRAJ1" | uint32 flags | int32 vertices | int32 faces | int32 frames | float fps
+//*   | int32 F[faces][3] | float positions[frames][vertices][3]
+//* With the Delta flag, frame 0 holds positions and every later frame the float difference to the frame
+//* before as the reader reconstructs it (the encoder runs the same float accumulation, so errors do not
+//* drift). Deltas are small and repetitive, which helps a general-purpose compressor on top.
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ArmParameters.h"
+#include "ArmMeshBuilder.h"
+#include "ArmMeshWriters.h"
+#include "WorkStealingPool.h"
+
+struct ArmKeyframe
+{
+    double time; // seconds
+    double Rad0;
+    double Rad1;
+};
+
+//* Rad0 and Rad1 interpolated linearly between keyframes (sorted by time), every other parameter from base.
+class ArmTrajectory
+{
+public:
+    ArmParameters base;
+    std::vector<ArmKeyframe> keyframes;
+
+    double duration() const { return keyframes.empty() ? 0 : keyframes.back().time - keyframes.front().time; }
+    //* Clamped to the first and last keyframe.
+    ArmParameters at(double time) const;
+};
+
+class ArmTrajectoryBaker
+{
+public:
+    enum Flags : uint32_t
+    {
+        Delta = 1 << 0
+    };
+
+    //* Without a pool, everything runs on the calling thread.
+    explicit ArmTrajectoryBaker(WorkStealingPool *pool = nullptr) : pool(pool) {}
+
+    //* Frame f shows the trajectory at keyframes.front().time + f / fps.
+    //* Returns false if the file could not be written or a frame has non-finite vertices.
+    bool bake(const ArmTrajectory &trajectory, int frames, double fps, const std::string &path, bool delta = false);
+
+    //* The common layout of the last bake().
+    const ArmMeshLayout &layout() const { return meshLayout; }
+
+    //* Frames per parallel task, and frames held in memory at once.
+    int grain = 4;
+    int chunkFrames = 256;
+
+private:
+    template <typename Function>
+    void forEach(int count, Function function);
+
+    WorkStealingPool *pool;
+    ArmMeshLayout meshLayout;
+};
+
+//* Sequential (or random, slower with Delta) access to the frames of a baked file.
+class ArmTrajectoryReader
+{
+public:
+    ArmTrajectoryReader() = default;
+    ~ArmTrajectoryReader() { close(); }
+
+    ArmTrajectoryReader(const ArmTrajectoryReader &) = delete;
+    ArmTrajectoryReader &operator=(const ArmTrajectoryReader &) = delete;
+
+    //* False for a malformed or truncated file (no frames, fps not positive, fewer frame records than the header says).
+    bool open(const std::string &path);
+    void close();
+
+    int vertices() const { return vertexCount; }
+    int frames() const { return frameCount; }
+    double fps() const { return framesPerSecond; }
+    bool delta() const { return (flags & ArmTrajectoryBaker::Delta) != 0; }
+    const Eigen::MatrixXi &F() const { return faces; }
+
+    //* V is resized to vertices() x 3. With Delta, going backwards replays from frame 0.
+    bool readFrame(int frame, Eigen::MatrixXd &V);
+
+private:
+    std::FILE *file = nullptr;
+    uint32_t flags = 0;
+    int vertexCount = 0;
+    int frameCount = 0;
+    double framesPerSecond = 0;
+    Eigen::MatrixXi faces;
+    long long dataOffset = 0;
+
+    //* 64-bit file positions: long is 32 bits on Windows, and a long trajectory passes 2 GB quickly.
+    static int seek(std::FILE *file, long long offset, int origin);
+    static long long tell(std::FILE *file);
+
+    std::vector<float> frameData;
+    std::vector<float> positions; // reconstructed positions of frame next - 1
+    int next = 0;                 // frame the file is positioned at
+};
+
+inline ArmParameters ArmTrajectory::at(double time) const
+{
+    ArmParameters p = base;
+    if (keyframes.empty())
+        return p;
+
+    auto after = std::upper_bound(keyframes.begin(), keyframes.end(), time, [](double t, const ArmKeyframe &key)
+                                  { return t < key.time; });
+    if (after == keyframes.begin() || after == keyframes.end())
+    {
+        const ArmKeyframe &key = after == keyframes.begin() ? keyframes.front() : keyframes.back();
+        p.Rad0 = key.Rad0;
+        p.Rad1 = key.Rad1;
+        return p;
+    }
+    const ArmKeyframe &a = *(after - 1), &b = *after;
+    double t = (time - a.time) / (b.time - a.time);
+    p.Rad0 = a.Rad0 + (b.Rad0 - a.Rad0) * t;
+    p.Rad1 = a.Rad1 + (b.Rad1 - a.Rad1) * t;
+    return p;
+}
+
+template <typename Function>
+void ArmTrajectoryBaker::forEach(int count, Function function)
+{
+    if (pool && count > grain)
+        pool->parallelFor(0, count, grain, function);
+    else
+        for (int i = 0; i < count; i++)
+            function(i);
+}
+
+inline bool ArmTrajectoryBaker::bake(const ArmTrajectory &trajectory, int frames, double fps, const std::string &path, bool delta)
+{
+    if (frames < 1 || !(fps > 0))
+        return false;
+    const double start = trajectory.keyframes.empty() ? 0 : trajectory.keyframes.front().time;
+    auto frameParameters = [&](int f)
+    { return trajectory.at(start + f / fps); };
+
+    //* One builder and one V per thread (plus the calling thread), reused across frames.
+    struct Workspace
+    {
+        ArmMeshBuilder builder;
+        Eigen::MatrixXd V;
+        int arcPoints[4] = {2, 2, 2, 2};
+    };
+    std::vector<Workspace> workspaces(pool ? pool->threadCount() + 1 : 1);
+    auto workspace = [&]() -> Workspace &
+    { return workspaces[pool ? pool->currentThreadIndex() : 0]; };
+
+    //* Pass 1: the largest point count of every arc over all frames.
+    forEach(frames, [&](int f)
+            {
+        Workspace &w = workspace();
+        const ArmMeshLayout &layout = w.builder.prepare(frameParameters(f));
+        for (int k = 0; k < 4; k++)
+            w.arcPoints[k] = std::max(w.arcPoints[k], layout.arcPoints[k]);
+        ARM_PROFILE_COMMIT(layout.vertices, layout.faces); });
+    int arcPoints[4] = {2, 2, 2, 2};
+    for (const Workspace &w : workspaces)
+        for (int k = 0; k < 4; k++)
+            arcPoints[k] = std::max(arcPoints[k], w.arcPoints[k]);
+
+    ArmMeshBuilder builder;
+    meshLayout = builder.prepare(frameParameters(0), arcPoints);
+    Eigen::MatrixXi F(meshLayout.faces, 3);
+    builder.writeFaces(F);
+
+    BufferedFileWriter out;
+    if (!out.open(path))
+        return false;
+    out.write("ARMTRAJ1", 8);
+    out.write(delta ? (uint32_t)Delta : 0u);
+    out.write((int32_t)meshLayout.vertices);
+    out.write((int32_t)meshLayout.faces);
+    out.write((int32_t)frames);
+    out.write((float)fps);
+    for (int i = 0; i < meshLayout.faces; i++)
+    {
+        int32_t indices[3] = {F(i, 0), F(i, 1), F(i, 2)};
+        out.write(indices, sizeof(indices));
+    }
+
+    //* Pass 2, chunk by chunk: mesh the frames in parallel, then encode and write them in order.
+    const size_t frameFloats = (size_t)meshLayout.vertices * 3;
+    std::vector<float> chunk(std::min(frames, chunkFrames) * frameFloats);
+    std::vector<float> previous(delta ? frameFloats : 0);
+    bool finite = true;
+    for (int first = 0; first < frames; first += chunkFrames)
+    {
+        const int count = std::min(chunkFrames, frames - first);
+        forEach(count, [&](int i)
+                {
+            Workspace &w = workspace();
+            const ArmParameters p = frameParameters(first + i);
+            w.builder.prepare(p, arcPoints);
+            w.V.resize(meshLayout.vertices, 3);
+            w.builder.writeFrontVertices(w.V);
+            w.builder.writeBackVertices(w.V, p.thickness);
+            float *positions = chunk.data() + i * frameFloats;
+            for (int v = 0; v < meshLayout.vertices; v++)
+                for (int c = 0; c < 3; c++)
+                    positions[3 * v + c] = (float)w.V(v, c);
+            ARM_PROFILE_COMMIT(meshLayout.vertices, meshLayout.faces); });
+
+        for (int i = 0; i < count; i++)
+        {
+            float *positions = chunk.data() + i * frameFloats;
+            for (size_t j = 0; j < frameFloats; j++)
+                finite = finite && std::isfinite(positions[j]);
+            if (delta)
+            {
+                //* Frame 0 starts from zero, so it stores its positions.
+                for (size_t j = 0; j < frameFloats; j++)
+                {
+                    float difference = positions[j] - previous[j];
+                    previous[j] += difference;
+                    positions[j] = difference;
+                }
+            }
+            out.write(positions, frameFloats * sizeof(float));
+        }
+    }
+    return out.close() && finite;
+}
+
+inline int ArmTrajectoryReader::seek(std::FILE *file, long long offset, int origin)
+{
+#ifdef _WIN32
+    return _fseeki64(file, offset, origin);
+#else
+    return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+inline long long ArmTrajectoryReader::tell(std::FILE *file)
+{
+#ifdef _WIN32
+    return _ftelli64(file);
+#else
+    return (long long)ftello(file);
+#endif
+}
+
+inline bool ArmTrajectoryReader::open(const std::string &path)
+{
+    close();
+    file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    char magic[8];
+    int32_t counts[3];
+    float rate;
+    if (std::fread(magic, 1, 8, file) != 8 || std::memcmp(magic, "ARMTRAJ1", 8) != 0 ||
+        std::fread(&flags, sizeof(flags), 1, file) != 1 || std::fread(counts, sizeof(counts), 1, file) != 1 ||
+        std::fread(&rate, sizeof(rate), 1, file) != 1 || counts[0] < 0 || counts[1] < 0 || counts[2] < 1 || !(rate > 0))
+    {
+        close();
+        return false;
+    }
+    vertexCount = counts[0];
+    frameCount = counts[2];
+    framesPerSecond = rate;
+
+    //* Eigen matrices are column major, the file is row major.
+    Eigen::Matrix<int32_t, Eigen::Dynamic, 3, Eigen::RowMajor> indices(counts[1], 3);
+    if (std::fread(indices.data(), sizeof(int32_t), indices.size(), file) != (size_t)indices.size() ||
+        (indices.size() > 0 && (indices.minCoeff() < 0 || indices.maxCoeff() >= vertexCount)))
+    {
+        close();
+        return false;
+    }
+    faces = indices.cast<int>();
+    dataOffset = tell(file);
+
+    //* A truncated file fails here instead of in the middle of playback.
+    const long long dataBytes = (long long)frameCount * vertexCount * 3 * (long long)sizeof(float);
+    if (dataOffset < 0 || seek(file, 0, SEEK_END) != 0 || tell(file) - dataOffset < dataBytes)
+    {
+        close();
+        return false;
+    }
+
+    frameData.resize((size_t)vertexCount * 3);
+    positions.assign((size_t)vertexCount * 3, 0.0f);
+    next = 0;
+    return true;
+}
+
+inline void ArmTrajectoryReader::close()
+{
+    if (file)
+        std::fclose(file);
+    file = nullptr;
+    vertexCount = frameCount = 0;
+    faces.resize(0, 3);
+}
+
+inline bool ArmTrajectoryReader::readFrame(int frame, Eigen::MatrixXd &V)
+{
+    if (!file || frame < 0 || frame >= frameCount)
+        return false;
+
+    const size_t frameBytes = frameData.size() * sizeof(float);
+    if (delta() && frame < next)
+    {
+        //* Deltas only go forward: start over.
+        positions.assign(positions.size(), 0.0f);
+        next = 0;
+    }
+    if (!delta())
+        next = frame;
+    if (seek(file, dataOffset + (long long)next * (long long)frameBytes, SEEK_SET) != 0)
+    {
+        next = frameCount;
+        return false;
+    }
+
+    for (; next <= frame; next++)
+    {
+        if (std::fread(frameData.data(), 1, frameBytes, file) != frameBytes)
+        {
+            //* Unknown state: the next read starts over.
+            next = frameCount;
+            return false;
+        }
+        if (delta())
+            for (size_t j = 0; j < positions.size(); j++)
+                positions[j] += frameData[j];
+        else
+            positions.swap(frameData);
+    }
+
+    V.resize(vertexCount, 3);
+    for (int v = 0; v < vertexCount; v++)
+        for (int c = 0; c < 3; c++)
+            V(v, c) = positions[3 * v + c];
+    return true;
+}
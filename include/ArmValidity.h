@@ -0,0 +1,236 @@
+//* Author: Zac Zhuo Zhang
+//* Analytic validity and clearance of an arm configuration, straight from the 2D profile primitives.
+//* No arc is divided and no mesh is built: evaluate() solves the same joints, tangent lines and fillet lines
+//* as ArmMeshBuilder and checks where the calculators would break down:
+//*   - getTangentLines0 takes acos(|r0 - r1| / length): out of domain when one joint circle contains the other,
+//*   - getTangentLines1 would take acos((r0 + r1) / length): out of domain when adjacent joint circles overlap,
+//*   - lineLineIntersection has no answer for parallel fillet lines (straight or fully folded arm),
+//*   - the fillet inverts when its tangent points leave the inner link sides (d too large, or the arm bent
+//*     counterclockwise so that the "inner" side is convex),
+//* and measures the clearance between the parts of the profile that are not joined: the end circles at P0
+//* and P2, and each end circle against the side of the other link (the hull of its two joint circles between
+//* the tangent points; the shared joint circle at P1 is not counted). Negative when they overlap.
+//* One evaluation is a few hundred nanoseconds. ArmWorkspaceMap samples a Rad0 x Rad1 grid on a WorkStealingPool.
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ArmParameters.h"
+#include "TangentLinesCalculator.h"
+#include "WorkStealingPool.h"
+
+struct ArmValidity
+{
+    enum Flags : unsigned
+    {
+        Link0Degenerate = 1 << 0, // |R0 - R1| >= length0, acos domain of getTangentLines0
+        Link1Degenerate = 1 << 1, // |R1 - R2| >= length1
+        Link0Overlap = 1 << 2,    // R0 + R1 > length0, acos domain of getTangentLines1
+        Link1Overlap = 1 << 3,    // R1 + R2 > length1
+        ParallelLines = 1 << 4,   // the fillet lines do not intersect
+        FilletInverted = 1 << 5,  // the fillet tangent points are not on the inner link sides
+        SelfIntersecting = 1 << 6 // clearance < 0
+    };
+
+    unsigned flags = 0;
+    double clearance = 0; // NaN when a link is degenerate
+    double filletRadius = 0;
+    Eigen::Vector2d endEffector = Eigen::Vector2d::Zero(); // P2
+
+    bool valid() const { return flags == 0; }
+    static const char *flagName(int bit);
+};
+
+class ArmValidityEvaluator
+{
+public:
+    ArmValidity evaluate(const ArmParameters &p);
+
+    //* Signed distance from x to the sides of the convex hull of circles (a, ra) and (b, rb), +infinity where x is
+    //* nearer to one of the circles than to the sides. Needs |ra - rb| < |b - a|.
+    static double sideDistance(const Eigen::Vector2d &x, const Eigen::Vector2d &a, double ra, const Eigen::Vector2d &b, double rb);
+
+private:
+    TangentLinesCalculator2D tangentLinesCalculator;
+};
+
+//* Validity over a rad0Count x rad1Count grid of joint angles, every other parameter from a base.
+class ArmWorkspaceMap
+{
+public:
+    //* Without a pool, everything runs on the calling thread.
+    explicit ArmWorkspaceMap(WorkStealingPool *pool = nullptr) : pool(pool) {}
+
+    //* Both angles default to the viewer's slider range.
+    //* Returns false, with an empty map, when the grid has more than INT_MAX cells (the pool's index range).
+    bool sample(const ArmParameters &base, int rad0Count, int rad1Count, double rad0Min = 0.1, double rad0Max = 1.5, double rad1Min = 0.1, double rad1Max = 1.5);
+
+    int rad0Count() const { return count0; }
+    int rad1Count() const { return count1; }
+    double rad0(int i) const { return count0 > 1 ? min0 + (max0 - min0) * i / (count0 - 1) : min0; }
+    double rad1(int j) const { return count1 > 1 ? min1 + (max1 - min1) * j / (count1 - 1) : min1; }
+    const ArmValidity &at(int i, int j) const { return cells[(size_t)j * count0 + i]; }
+    int validCount() const;
+
+    //* One row per cell: Rad0, Rad1, P2, clearance, flags.
+    bool writeCsv(const std::string &path) const;
+
+    //* Cells per parallel task.
+    int grain = 256;
+
+private:
+    WorkStealingPool *pool;
+    int count0 = 0, count1 = 0;
+    double min0 = 0, max0 = 0, min1 = 0, max1 = 0;
+    std::vector<ArmValidity> cells; // Rad0 fastest
+};
+
+inline const char *ArmValidity::flagName(int bit)
+{
+    static const char *names[] = {"Link0Degenerate", "Link1Degenerate", "Link0Overlap", "Link1Overlap", "ParallelLines", "FilletInverted", "SelfIntersecting"};
+    return bit >= 0 && bit < 7 ? names[bit] : "";
+}
+
+inline double ArmValidityEvaluator::sideDistance(const Eigen::Vector2d &x, const Eigen::Vector2d &a, double ra, const Eigen::Vector2d &b, double rb)
+{
+    //* In the frame of the axis a -> b: the hull is symmetric, fold x onto the left side.
+    const double h = (b - a).norm();
+    const Eigen::Vector2d axis = (b - a) / h;
+    const Eigen::Vector2d local((x - a).dot(axis), std::abs(axis.x() * (x - a).y() - axis.y() * (x - a).x()));
+
+    //* The side tangent touches circle a at angle acos((ra - rb) / h) from the axis.
+    const double sinSide = (ra - rb) / h;
+    const double cosSide = std::sqrt(1 - sinSide * sinSide);
+    const double along = local.x() * cosSide - local.y() * sinSide; // position along the side tangent
+    if (along < 0 || along > cosSide * h)
+        return INFINITY;
+    return local.x() * sinSide + local.y() * cosSide - ra;
+}
+
+inline ArmValidity ArmValidityEvaluator::evaluate(const ArmParameters &p)
+{
+    ArmValidity result;
+
+    //* Joints, as ArmMeshBuilder::solveLink0/1.
+    const Eigen::Vector2d P0(0, 0);
+    const Eigen::Vector2d P1(p.length0 * std::cos(p.Rad0), p.length0 * std::sin(p.Rad0));
+    const Eigen::Vector2d P2 = P1 + Eigen::Vector2d(std::cos(-p.Rad1) * p.length1, std::sin(-p.Rad1) * p.length1);
+    result.endEffector = P2;
+
+    const double link0 = (P1 - P0).norm(), link1 = (P2 - P1).norm();
+    if (std::abs(p.R0 - p.R1) >= link0)
+        result.flags |= ArmValidity::Link0Degenerate;
+    if (std::abs(p.R1 - p.R2) >= link1)
+        result.flags |= ArmValidity::Link1Degenerate;
+    if (p.R0 + p.R1 > link0)
+        result.flags |= ArmValidity::Link0Overlap;
+    if (p.R1 + p.R2 > link1)
+        result.flags |= ArmValidity::Link1Overlap;
+    if (result.flags & (ArmValidity::Link0Degenerate | ArmValidity::Link1Degenerate))
+    {
+        //* No tangent lines, nothing else is defined.
+        result.clearance = NAN;
+        result.filletRadius = NAN;
+        return result;
+    }
+
+    //* End circles against each other and against the other link's sides.
+    result.clearance = std::min({(P2 - P0).norm() - p.R0 - p.R2,
+                                 sideDistance(P2, P0, p.R0, P1, p.R1) - p.R2,
+                                 sideDistance(P0, P1, p.R1, P2, p.R2) - p.R0});
+    if (result.clearance < 0)
+        result.flags |= ArmValidity::SelfIntersecting;
+
+    //* Fillet lines, as ArmMeshBuilder::solveFillet: the inner sides of both links, pointing towards P1.
+    const TangentLinesCalculator2D::Points tan0Points = tangentLinesCalculator.getTangentLines0(P0, p.R0, P1, p.R1);
+    const TangentLinesCalculator2D::Points tan1Points = tangentLinesCalculator.getTangentLines0(P1, p.R1, P2, p.R2);
+    const Eigen::Vector2d start0 = tan0Points.row(2), end0 = tan0Points.row(3);
+    const Eigen::Vector2d start1 = tan1Points.row(3), end1 = tan1Points.row(2);
+    const Eigen::Vector2d D0 = end0 - start0, D1 = end1 - start1;
+
+    //* Same threshold as lineLineIntersection.
+    const double cross = D0.x() * D1.y() - D0.y() * D1.x();
+    if (std::abs(cross) < 1e-6)
+    {
+        result.flags |= ArmValidity::ParallelLines;
+        result.filletRadius = NAN;
+        return result;
+    }
+
+    //* Intersection at start0 + t0 D0 = start1 + t1 D1; the tangent points are d before it on both lines.
+    const Eigen::Vector2d v = start1 - start0;
+    const double t0 = (v.x() * D1.y() - v.y() * D1.x()) / cross;
+    const double t1 = (v.x() * D0.y() - v.y() * D0.x()) / cross;
+    const double length0 = D0.norm(), length1 = D1.norm();
+    const double before0 = t0 * length0, before1 = t1 * length1; // distance from the line starts to the intersection
+    if (!(before0 >= p.d && before0 <= length0 && before1 >= p.d && before1 <= length1))
+        result.flags |= ArmValidity::FilletInverted;
+
+    //* radius = d tan(angle / 2) with cos(angle) = D0.D1 / (|D0| |D1|), as getTangentCircleCenter.
+    const double cosAngle = std::min(std::max(D0.dot(D1) / (length0 * length1), -1.0), 1.0);
+    result.filletRadius = p.d * std::sqrt((1 - cosAngle) / (1 + cosAngle));
+    return result;
+}
+
+inline bool ArmWorkspaceMap::sample(const ArmParameters &base, int rad0Count, int rad1Count, double rad0Min, double rad0Max, double rad1Min, double rad1Max)
+{
+    count0 = std::max(rad0Count, 0);
+    count1 = std::max(rad1Count, 0);
+    min0 = rad0Min, max0 = rad0Max, min1 = rad1Min, max1 = rad1Max;
+    if ((long long)count0 * count1 > INT_MAX)
+    {
+        count0 = count1 = 0;
+        cells.clear();
+        return false;
+    }
+    cells.assign((size_t)count0 * count1, ArmValidity());
+
+    //* One evaluator per thread (plus the calling thread).
+    std::vector<ArmValidityEvaluator> evaluators(pool ? pool->threadCount() + 1 : 1);
+    auto evaluate = [&](int cell)
+    {
+        ArmParameters p = base;
+        p.Rad0 = rad0(cell % count0);
+        p.Rad1 = rad1(cell / count0);
+        cells[cell] = evaluators[pool ? pool->currentThreadIndex() : 0].evaluate(p);
+    };
+    const int count = (int)cells.size();
+    if (pool && count > grain)
+        pool->parallelFor(0, count, grain, evaluate);
+    else
+        for (int cell = 0; cell < count; cell++)
+            evaluate(cell);
+    return true;
+}
+
+inline int ArmWorkspaceMap::validCount() const
+{
+    int valid = 0;
+    for (const ArmValidity &cell : cells)
+        valid += cell.valid();
+    return valid;
+}
+
+inline bool ArmWorkspaceMap::writeCsv(const std::string &path) const
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    out.precision(17);
+    out << "Rad0,Rad1,x,y,clearance,flags\n";
+    for (int j = 0; j < count1; j++)
+        for (int i = 0; i < count0; i++)
+        {
+            const ArmValidity &cell = at(i, j);
+            out << rad0(i) << ',' << rad1(j) << ',' << cell.endEffector.x() << ',' << cell.endEffector.y() << ','
+                << cell.clearance << ',' << cell.flags << '\n';
+        }
+    return (bool)out;
+}
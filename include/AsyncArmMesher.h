@@ -0,0 +1,209 @@
+//* Author: Zac Zhuo Zhang
+//* Generate the arm mesh on a background thread, off the render loop.
+//* request() only records the newest parameters: while the worker is busy, newer requests replace
+//* older pending ones (latest wins), so a dragged slider never queues a rebuild per intermediate value.
+//* The worker updates its own ArmModel (so rebuilds stay incremental) and publishes the result into a
+//* ready buffer; poll() swaps it with the front buffer the UI draws from.
+//* The UI keeps showing the last completed mesh until a newer one is ready.
+//* Meshes come with analytic per-vertex normals (split side vertices), so the UI never recomputes them.
+//* A request can ask for a level of detail instead of the parameters' MeshMaxDistance; the worker keeps
+//* those in an ArmLodCache, so going back to a level of the current parameters only copies it.
+//* Other requests go through an ArmMeshCache first: scrubbing a slider back to a recent value, or dragging
+//* the thickness, is a lookup. A miss is meshed through the ArmProfile it inserts, the same view a hit
+//* reads, so the mesh of a configuration does not depend on whether it was cached.
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <Eigen/Dense>
+
+#include "ArmParameters.h"
+#include "ArmModel.h"
+#include "ArmLodCache.h"
+#include "ArmMeshCache.h"
+#include "ArmProfiler.h"
+
+class AsyncArmMesher
+{
+public:
+    struct Mesh
+    {
+        Eigen::MatrixXd V;
+        Eigen::MatrixXi F;
+        Eigen::MatrixXd N;
+        ArmParameters parameters;
+        ArmMeshLayout layout;
+        int level = -1; // level of detail, -1: parameters.MeshMaxDistance
+        unsigned long long generation = 0;
+    };
+
+    //* Builds the first mesh synchronously, so current() is valid right away.
+    explicit AsyncArmMesher(const ArmParameters &p = ArmParameters());
+    ~AsyncArmMesher();
+
+    AsyncArmMesher(const AsyncArmMesher &) = delete;
+    AsyncArmMesher &operator=(const AsyncArmMesher &) = delete;
+
+    //* level >= 0 meshes with lods().meshMaxDistance(level) instead of p.MeshMaxDistance.
+    void request(const ArmParameters &p, int level = -1);
+
+    //* Level spacing only (levels, meshMaxDistance, selectLevel); the worker owns the meshes.
+    const ArmLodCache &lods() const { return lodCache; }
+
+    ArmMeshCache::Statistics cacheStatistics() const { return meshCache.statistics(); }
+
+    //* Take the newest finished mesh, if any. Returns true when current() changed;
+    //* topologyChanged tells whether F differs from the previous current() (false: vertex-only update).
+    bool poll(bool &topologyChanged);
+
+    const Mesh &current() const { return front; }
+
+    //* True while the newest request is not in current() yet.
+    bool busy() const;
+
+private:
+    void workerLoop();
+
+    ArmModel model;
+    ArmLodCache lodCache{0.1, 0.5, 8, true};
+    ArmMeshCache meshCache{size_t(128) << 20, 1e-6};
+
+    Mesh front;    // UI thread only
+    Mesh ready;    // guarded by mutex
+    Mesh building; // worker only
+    bool readyAvailable = false;
+
+    ArmParameters pending;
+    int pendingLevel = -1;
+    bool hasPending = false;
+    unsigned long long requested = 0;
+    bool stopping = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::thread worker;
+};
+
+inline AsyncArmMesher::AsyncArmMesher(const ArmParameters &p) : model(p, true)
+{
+    model.update();
+    std::shared_ptr<ArmProfile> profile = std::make_shared<ArmProfile>();
+    model.writeProfile(*profile);
+    meshCache.insert(p, profile);
+    profile->toMatrices(p.thickness, front.V, front.F, &front.N);
+    front.parameters = p;
+    front.layout = profile->layout();
+
+    worker = std::thread(&AsyncArmMesher::workerLoop, this);
+}
+
+inline AsyncArmMesher::~AsyncArmMesher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    worker.join();
+}
+
+inline void AsyncArmMesher::request(const ArmParameters &p, int level)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = p;
+        pendingLevel = level;
+        hasPending = true;
+        requested++;
+    }
+    wakeUp.notify_one();
+}
+
+inline bool AsyncArmMesher::poll(bool &topologyChanged)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!readyAvailable)
+        return false;
+
+    topologyChanged = !ready.layout.sameTopology(front.layout);
+    std::swap(front, ready);
+    readyAvailable = false;
+    return true;
+}
+
+inline bool AsyncArmMesher::busy() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return requested != front.generation;
+}
+
+inline void AsyncArmMesher::workerLoop()
+{
+    while (true)
+    {
+        ArmParameters p;
+        int level;
+        unsigned long long generation;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this]
+                        { return stopping || hasPending; });
+            if (stopping)
+                return;
+            p = pending;
+            level = pendingLevel;
+            generation = requested;
+            hasPending = false;
+        }
+
+        std::shared_ptr<const ArmProfile> cached = level < 0 ? meshCache.find(p, true) : nullptr;
+        const ArmModel *source = &model;
+        if (level >= 0)
+        {
+            lodCache.setParameters(p);
+            source = &lodCache.level(level);
+        }
+        else if (!cached)
+        {
+            //* The model only catches up on a miss; its update stays incremental from wherever it was.
+            model.setParameters(p);
+            model.update();
+            std::shared_ptr<ArmProfile> profile = std::make_shared<ArmProfile>();
+            model.writeProfile(*profile);
+            meshCache.insert(p, profile);
+            cached = profile;
+        }
+
+        {
+            ARM_PROFILE_SCOPE(ArmStage::Concatenation);
+            if (cached)
+            {
+                //* Profiles extrude to the requested thickness.
+                cached->toMatrices(p.thickness, building.V, building.F, &building.N);
+                building.layout = cached->layout();
+            }
+            else
+            {
+                //* Copies reuse the buffers' storage when the size is unchanged.
+                building.V = source->V();
+                building.F = source->F();
+                building.N = source->N();
+                building.layout = source->layout();
+            }
+            building.parameters = p;
+            building.level = level;
+            building.generation = generation;
+        }
+        ARM_PROFILE_COMMIT((int)building.V.rows(), (int)building.F.rows());
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            //* An unconsumed older mesh is simply replaced.
+            std::swap(ready, building);
+            readyAvailable = true;
+        }
+    }
+}
@@ -2,59 +2,204 @@
 //* Divide the Arc based on the given distance,
 //* Shorter distance means smoother arc edges,
 //* Longer distance means less points on the arc, minimum 2 points.
+//* Two tessellation modes give the same number of points with the same end points, and interior points
+//* that match to within rounding error:
+//* Exact evaluates cos/sin for every point.
+//* Recurrence rotates four interleaved points by a constant step, re-anchored with exact cos/sin
+//* every reanchorInterval points to bound the drift (about 1e-15 in double, more in float); it is the
+//* fast path for fine resolutions.
+//* The fixed-count overload divides the arc into a given number of points with a uniform step instead,
+//* so meshes of a moving arm can keep one topology (see ArmTrajectory.h).
+//* Templated on the scalar the points are computed in (CircleArcDivider2D: double, CircleArcDivider2Df: float).
+//* The output rows can be of any scalar type, independent of it: x and y go into the first two columns,
+//* and a third column, if there is one, gets z = 0.
+
+#pragma once
 
 #include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+
+enum class ArcTessellation
+{
+    Exact,
+    Recurrence
+};
 
-class CircleArcDivider2D
+template <typename Scalar>
+class BasicCircleArcDivider2D
 {
 public:
-    Eigen::MatrixXd divideArc2D(const Eigen::Vector3d &center, double radius, const Eigen::Vector3d &pointA, const Eigen::Vector3d &pointB, double distance);
+    typedef Eigen::Matrix<Scalar, 2, 1> Point;
+
+    explicit BasicCircleArcDivider2D(ArcTessellation mode = ArcTessellation::Exact) : mode(mode) {}
+
+    ArcTessellation mode;
+    static const int reanchorInterval = 64;
+    //* Upper bound of the point count of one arc: a distance that is tiny (or zero, or NaN) against the
+    //* radius would otherwise overflow the int count that sizes the caller's buffers.
+    static const int maxArcPoints = 1 << 16;
+
+    //* Number of points divideArc2D produces for the same arguments.
+    int countArcPoints(const Point &center, Scalar radius, const Point &pointA, const Point &pointB, Scalar distance) const;
+    //* Write the points into caller-owned rows, points.rows() must be countArcPoints(...) (no heap allocation).
+    //* points may be a temporary block (V.middleRows(...)), it is written through as in Eigen's own functions.
+    template <typename Derived>
+    void divideArc2D(const Point &center, Scalar radius, const Point &pointA, const Point &pointB, Scalar distance, const Eigen::MatrixBase<Derived> &points) const;
+    //* Exactly points.rows() (at least 2) points from A to B with a uniform angular step.
+    template <typename Derived>
+    void divideArc2D(const Point &center, const Point &pointA, const Point &pointB, const Eigen::MatrixBase<Derived> &points) const;
+
+    //* Counterclockwise angle between consecutive points of either overload; the last step, to B, may be shorter.
+    Scalar arcStep(const Point &center, Scalar radius, const Point &pointA, const Point &pointB, Scalar distance) const;
+    Scalar arcStep(const Point &center, const Point &pointA, const Point &pointB, int numberOfPoints) const;
+
+private:
+    Scalar arcAngle(const Point &center, const Point &pointA, const Point &pointB) const;
+    void arcRange(const Point &center, Scalar radius, const Point &pointA, const Point &pointB, Scalar distance, Scalar &deltaRadius, int &numberOfPoints) const;
+    template <typename Derived>
+    void writePoints(const Point &center, const Point &pointA, const Point &pointB, Scalar deltaRadius, Eigen::MatrixBase<Derived> &points) const;
 };
 
-Eigen::MatrixXd CircleArcDivider2D::divideArc2D(const Eigen::Vector3d &center, double radius, const Eigen::Vector3d &pointA, const Eigen::Vector3d &pointB, double distance)
+typedef BasicCircleArcDivider2D<double> CircleArcDivider2D;
+typedef BasicCircleArcDivider2D<float> CircleArcDivider2Df;
+
+template <typename Scalar>
+int BasicCircleArcDivider2D<Scalar>::countArcPoints(const Point &center, Scalar radius, const Point &pointA, const Point &pointB, Scalar distance) const
+{
+    Scalar deltaRadius;
+    int numberOfPoints;
+    arcRange(center, radius, pointA, pointB, distance, deltaRadius, numberOfPoints);
+    return numberOfPoints;
+}
+
+template <typename Scalar>
+Scalar BasicCircleArcDivider2D<Scalar>::arcStep(const Point &center, Scalar radius, const Point &pointA, const Point &pointB, Scalar distance) const
+{
+    Scalar deltaRadius;
+    int numberOfPoints;
+    arcRange(center, radius, pointA, pointB, distance, deltaRadius, numberOfPoints);
+    return deltaRadius;
+}
+
+template <typename Scalar>
+Scalar BasicCircleArcDivider2D<Scalar>::arcStep(const Point &center, const Point &pointA, const Point &pointB, int numberOfPoints) const
 {
+    return arcAngle(center, pointA, pointB) / (numberOfPoints - 1);
+}
 
+template <typename Scalar>
+Scalar BasicCircleArcDivider2D<Scalar>::arcAngle(const Point &center, const Point &pointA, const Point &pointB) const
+{
     //* Calculate the radians angle between the two points.
-    double dotProduct = (pointA - center).dot(pointB - center);
-    double lengthA = (pointA - center).norm();
-    double lengthB = (pointB - center).norm();
-    double rRange = std::acos(dotProduct / (lengthA * lengthB));
-    // std::cout << "dotProduct / (lengthA * lengthB): " << dotProduct / (lengthA * lengthB) << std::endl;
-    if (std::abs(dotProduct / (lengthA * lengthB)+1) < 0.000001)
-        rRange = M_PI;
+    Scalar dotProduct = (pointA - center).dot(pointB - center);
+    Scalar lengthA = (pointA - center).norm();
+    Scalar lengthB = (pointB - center).norm();
+    Scalar rRange = std::acos(dotProduct / (lengthA * lengthB));
+    if (std::abs(dotProduct / (lengthA * lengthB) + 1) < Scalar(0.000001))
+        rRange = Scalar(M_PI);
+
+    return rRange;
+}
 
-    // std::cout << "Radius: " << rRange << std::endl;
+template <typename Scalar>
+void BasicCircleArcDivider2D<Scalar>::arcRange(const Point &center, Scalar radius, const Point &pointA, const Point &pointB, Scalar distance, Scalar &deltaRadius, int &numberOfPoints) const
+{
+    Scalar rRange = arcAngle(center, pointA, pointB);
 
     //* Calculate the delta radius.
-    double deltaRadius = 2 * std::asin(distance / (2 * radius));
-    // std::cout << "Delta radius: " << deltaRadius << std::endl;
+    deltaRadius = 2 * std::asin(distance / (2 * radius));
+
+    //* Calculate the number of points, range checked in floating point before the conversion (NaN gives 2).
+    double count = std::ceil((double)rRange / (double)deltaRadius) + 1;
+    numberOfPoints = count >= 2 ? (int)std::min(count, (double)maxArcPoints) : 2;
+}
+
+template <typename Scalar>
+template <typename Derived>
+void BasicCircleArcDivider2D<Scalar>::divideArc2D(const Point &center, Scalar radius, const Point &pointA, const Point &pointB, Scalar distance, const Eigen::MatrixBase<Derived> &points) const
+{
+    Scalar deltaRadius;
+    int numberOfPoints;
+    arcRange(center, radius, pointA, pointB, distance, deltaRadius, numberOfPoints);
+    eigen_assert(points.rows() == numberOfPoints && (points.cols() == 2 || points.cols() == 3));
+    writePoints(center, pointA, pointB, deltaRadius, const_cast<Eigen::MatrixBase<Derived> &>(points));
+}
+
+template <typename Scalar>
+template <typename Derived>
+void BasicCircleArcDivider2D<Scalar>::divideArc2D(const Point &center, const Point &pointA, const Point &pointB, const Eigen::MatrixBase<Derived> &points) const
+{
+    eigen_assert(points.rows() >= 2 && (points.cols() == 2 || points.cols() == 3));
+    writePoints(center, pointA, pointB, arcStep(center, pointA, pointB, (int)points.rows()), const_cast<Eigen::MatrixBase<Derived> &>(points));
+}
+
+template <typename Scalar>
+template <typename Derived>
+void BasicCircleArcDivider2D<Scalar>::writePoints(const Point &center, const Point &pointA, const Point &pointB, Scalar deltaRadius, Eigen::MatrixBase<Derived> &points) const
+{
+    typedef typename Derived::Scalar Output;
+    const int numberOfPoints = (int)points.rows();
+    const bool hasZ = points.cols() > 2;
+    Point vecA = pointA - center;
 
-    //* Calculate the number of points.
-    int numberOfPoints = std::ceil(rRange / deltaRadius) + 1;
-    if (numberOfPoints < 2)
-        numberOfPoints = 2;
-    // std::cout << "Number of points: " << numberOfPoints << std::endl;
-    Eigen::Vector3d vecA = pointA - center;
-    Eigen::MatrixXd points(numberOfPoints, 3);
+    auto put = [&](int i, Scalar x, Scalar y)
+    {
+        points(i, 0) = Output(x);
+        points(i, 1) = Output(y);
+        if (hasZ)
+            points(i, 2) = Output(0);
+    };
 
-    points.row(0) = pointA;
+    put(0, pointA.x(), pointA.y());
 
-    for (int i = 1; i < numberOfPoints - 1; i++)
+    if (mode == ArcTessellation::Exact)
     {
-        double r = i * deltaRadius;
+        for (int i = 1; i < numberOfPoints - 1; i++)
+        {
+            Scalar r = i * deltaRadius;
 
-        Eigen::Matrix3d rotationMatrix;
-        rotationMatrix << std::cos(r), -std::sin(r), 0,
-            std::sin(r), std::cos(r), 0,
-            0, 0, 1;
+            Eigen::Matrix<Scalar, 2, 2> rotationMatrix;
+            rotationMatrix << std::cos(r), -std::sin(r),
+                std::sin(r), std::cos(r);
 
-        Eigen::Vector3d rotatedVector = rotationMatrix * vecA;
-        points.row(i) = rotatedVector + center;
+            Point rotatedVector = rotationMatrix * vecA + center;
+            put(i, rotatedVector.x(), rotatedVector.y());
+        }
     }
+    else
+    {
+        //* Lane j holds point i + j, all lanes advance by Lanes steps at once so the inner loops vectorize.
+        const int Lanes = 4;
+        const Scalar stepCos = std::cos(Lanes * deltaRadius);
+        const Scalar stepSin = std::sin(Lanes * deltaRadius);
+
+        for (int block = 1; block < numberOfPoints - 1; block += reanchorInterval)
+        {
+            int blockEnd = std::min(block + reanchorInterval, numberOfPoints - 1);
 
-    points.row(numberOfPoints - 1) = pointB;
+            Scalar x[Lanes], y[Lanes];
+            for (int j = 0; j < Lanes; j++)
+            {
+                Scalar r = (block + j) * deltaRadius;
+                x[j] = vecA.x() * std::cos(r) - vecA.y() * std::sin(r);
+                y[j] = vecA.x() * std::sin(r) + vecA.y() * std::cos(r);
+            }
 
-    // std::cout << "Number of points: " << points.size() << std::endl;
+            for (int i = block; i < blockEnd; i += Lanes)
+            {
+                int count = std::min(Lanes, blockEnd - i);
+                for (int j = 0; j < count; j++)
+                    put(i + j, x[j] + center.x(), y[j] + center.y());
+                for (int j = 0; j < Lanes; j++)
+                {
+                    Scalar rotatedX = stepCos * x[j] - stepSin * y[j];
+                    y[j] = stepSin * x[j] + stepCos * y[j];
+                    x[j] = rotatedX;
+                }
+            }
+        }
+    }
 
-    return points;
-}
\ No newline at end of file
+    put(numberOfPoints - 1, pointB.x(), pointB.y());
+}
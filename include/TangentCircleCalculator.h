@@ -1,59 +1,150 @@
 //* Author: Zac Zhuo Zhang
-//* Calculate the tangent circle center of two non-parallel lines in 2D-XY space (Z = 0).
+//* Calculate the tangent circle center of two non-parallel lines in 2D-XY space.
 //* The distance between the line-line intersection and the tangent point (d) is a given value.
 //* Knowing that there are four tangent circles:
 //* The outcome is determined by the sequence input points that defines the line directions.
+//* getTangentCircleCenterBatch solves N line pairs given as structure-of-arrays, with the half-angle
+//* trig replaced by square roots and masks instead of branches so the loop vectorizes (AVX2/NEON).
+//* Templated on the scalar type like TangentLinesCalculator.h: TangentCircleCalculator2D (double) and
+//* TangentCircleCalculator2Df (float), with fixed-size 2D points.
+
+#pragma once
 
 #include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+//* N line pairs (l0p0 -> l0p1, l1p0 -> l1p1) in the XY plane and their distances d, as structure-of-arrays.
+template <typename Scalar>
+struct BasicLinePairsSoA
+{
+    const Scalar *l0p0x, *l0p0y, *l0p1x, *l0p1y;
+    const Scalar *l1p0x, *l1p0y, *l1p1x, *l1p1y;
+    const Scalar *d;
+    int count;
+};
+
+//* N tangent circles, as structure-of-arrays. tan0/tan1 are the rows 0/1 of tanPoints.
+template <typename Scalar>
+struct BasicTangentCirclesSoA
+{
+    Scalar *centerX, *centerY, *radius;
+    Scalar *tan0X, *tan0Y;
+    Scalar *tan1X, *tan1Y;
+};
+
+typedef BasicLinePairsSoA<double> LinePairsSoA;
+typedef BasicLinePairsSoA<float> LinePairsSoAf;
+typedef BasicTangentCirclesSoA<double> TangentCirclesSoA;
+typedef BasicTangentCirclesSoA<float> TangentCirclesSoAf;
 
-class TangentCircleCalculator2D
+template <typename Scalar>
+class BasicTangentCircleCalculator2D
 {
 public:
-    std::pair<Eigen::Vector3d, double> getTangentCircleCenter(const Eigen::Vector3d &l0p0, const Eigen::Vector3d &l0p1, const Eigen::Vector3d &l1p0, const Eigen::Vector3d &l1p1, double d, Eigen::MatrixXd &tanPoints);
-    Eigen::Vector3d lineLineIntersection(const Eigen::Vector3d &l0p0, const Eigen::Vector3d &l0p1, const Eigen::Vector3d &l1p0, const Eigen::Vector3d &l1p1);
+    typedef Eigen::Matrix<Scalar, 2, 1> Point;
+    //* Row k is the tangent point on line k.
+    typedef Eigen::Matrix<Scalar, 2, 2> Points;
+
+    std::pair<Point, Scalar> getTangentCircleCenter(const Point &l0p0, const Point &l0p1, const Point &l1p0, const Point &l1p1, Scalar d, Points &tanPoints) const;
+    void getTangentCircleCenterBatch(const BasicLinePairsSoA<Scalar> &lines, const BasicTangentCirclesSoA<Scalar> &circles) const;
+    Point lineLineIntersection(const Point &l0p0, const Point &l0p1, const Point &l1p0, const Point &l1p1) const;
 };
 
-std::pair<Eigen::Vector3d, double> TangentCircleCalculator2D::getTangentCircleCenter(const Eigen::Vector3d &l0p0, const Eigen::Vector3d &l0p1, const Eigen::Vector3d &l1p0, const Eigen::Vector3d &l1p1, double d, Eigen::MatrixXd &tanPoints)
+typedef BasicTangentCircleCalculator2D<double> TangentCircleCalculator2D;
+typedef BasicTangentCircleCalculator2D<float> TangentCircleCalculator2Df;
+
+template <typename Scalar>
+std::pair<typename BasicTangentCircleCalculator2D<Scalar>::Point, Scalar> BasicTangentCircleCalculator2D<Scalar>::getTangentCircleCenter(const Point &l0p0, const Point &l0p1, const Point &l1p0, const Point &l1p1, Scalar d, Points &tanPoints) const
 {
     //* Intersection
-    Eigen::Vector3d intersection = lineLineIntersection(l0p0, l0p1, l1p0, l1p1);
+    Point intersection = lineLineIntersection(l0p0, l0p1, l1p0, l1p1);
 
     //* Calculate the radians angle between the two lines.
-    double dotProduct = (l0p1 - l0p0).dot(l1p1 - l1p0);
-    double length0 = (l0p1 - l0p0).norm();
-    double length1 = (l1p1 - l1p0).norm();
-    double angle = std::acos(dotProduct / (length0 * length1));
+    Scalar dotProduct = (l0p1 - l0p0).dot(l1p1 - l1p0);
+    Scalar length0 = (l0p1 - l0p0).norm();
+    Scalar length1 = (l1p1 - l1p0).norm();
+    Scalar angle = std::acos(dotProduct / (length0 * length1));
 
     //* Distance between the intersection point and the tangent point.
-    double radius = d * std::tan(angle / 2);
+    Scalar radius = d * std::tan(angle / 2);
 
     // * Get the center
-    Eigen::Vector3d center = intersection - (d / std::cos(angle / 2)) * ((l0p1 - l0p0).normalized() + (l1p1 - l1p0).normalized()).normalized();
+    Point center = intersection - (d / std::cos(angle / 2)) * ((l0p1 - l0p0).normalized() + (l1p1 - l1p0).normalized()).normalized();
 
-    tanPoints = Eigen::MatrixXd(2, 3);
     tanPoints.row(0) = intersection - (radius / (std::tan(angle / 2))) * ((l0p1 - l0p0).normalized());
     tanPoints.row(1) = intersection - (radius / (std::tan(angle / 2))) * ((l1p1 - l1p0).normalized());
 
-    return std::pair<Eigen::Vector3d, double>(center, radius);
+    return std::pair<Point, Scalar>(center, radius);
 }
 
-Eigen::Vector3d TangentCircleCalculator2D::lineLineIntersection(const Eigen::Vector3d &l0p0, const Eigen::Vector3d &l0p1, const Eigen::Vector3d &l1p0, const Eigen::Vector3d &l1p1)
+template <typename Scalar>
+typename BasicTangentCircleCalculator2D<Scalar>::Point BasicTangentCircleCalculator2D<Scalar>::lineLineIntersection(const Point &l0p0, const Point &l0p1, const Point &l1p0, const Point &l1p1) const
 {
-    Eigen::Vector3d D0 = l0p1 - l0p0;
-    Eigen::Vector3d D1 = l1p1 - l1p0;
+    Point D0 = l0p1 - l0p0;
+    Point D1 = l1p1 - l1p0;
 
-    Eigen::Vector3d v = l1p0 - l0p0;
-    Eigen::Vector3d crossD0D1 = D0.cross(D1);
+    Point v = l1p0 - l0p0;
+    //* The z of the 3D cross products, the lines are in the XY plane.
+    Scalar crossD0D1 = std::abs(D0.x() * D1.y() - D0.y() * D1.x());
 
-    if (crossD0D1.norm() < 1e-6)
+    if (crossD0D1 < Scalar(1e-6))
     {
-        return Eigen::Vector3d::Zero();
+        return Point::Zero();
     }
 
-    double t = v.cross(D1).norm() / crossD0D1.norm();
-    double s = v.cross(D0).norm() / crossD0D1.norm();
+    Scalar t = std::abs(v.x() * D1.y() - v.y() * D1.x()) / crossD0D1;
 
-    Eigen::Vector3d intersectionPoint = l0p0 + t * D0;
+    Point intersectionPoint = l0p0 + t * D0;
 
     return intersectionPoint;
 }
+
+template <typename Scalar>
+void BasicTangentCircleCalculator2D<Scalar>::getTangentCircleCenterBatch(const BasicLinePairsSoA<Scalar> &lines, const BasicTangentCirclesSoA<Scalar> &circles) const
+{
+    const Scalar *__restrict l0p0x = lines.l0p0x, *__restrict l0p0y = lines.l0p0y, *__restrict l0p1x = lines.l0p1x, *__restrict l0p1y = lines.l0p1y;
+    const Scalar *__restrict l1p0x = lines.l1p0x, *__restrict l1p0y = lines.l1p0y, *__restrict l1p1x = lines.l1p1x, *__restrict l1p1y = lines.l1p1y;
+    const Scalar *__restrict d = lines.d;
+    Scalar *__restrict centerX = circles.centerX, *__restrict centerY = circles.centerY, *__restrict radius = circles.radius;
+    Scalar *__restrict tan0X = circles.tan0X, *__restrict tan0Y = circles.tan0Y;
+    Scalar *__restrict tan1X = circles.tan1X, *__restrict tan1Y = circles.tan1Y;
+    const Scalar minCross = Scalar(1e-6);
+
+#pragma omp simd
+    for (int i = 0; i < lines.count; i++)
+    {
+        //* Intersection, as lineLineIntersection (the origin for parallel lines)
+        Scalar D0x = l0p1x[i] - l0p0x[i], D0y = l0p1y[i] - l0p0y[i];
+        Scalar D1x = l1p1x[i] - l1p0x[i], D1y = l1p1y[i] - l1p0y[i];
+        Scalar vx = l1p0x[i] - l0p0x[i], vy = l1p0y[i] - l0p0y[i];
+        Scalar crossD0D1 = std::abs(D0x * D1y - D0y * D1x);
+        Scalar notParallel = crossD0D1 >= minCross;
+        Scalar t = std::abs(vx * D1y - vy * D1x) / std::max(crossD0D1, minCross);
+        Scalar intersectionX = notParallel * (l0p0x[i] + t * D0x);
+        Scalar intersectionY = notParallel * (l0p0y[i] + t * D0y);
+
+        //* angle = acos(u0 . u1), tan(angle / 2) = sin / (1 + cos), cos(angle / 2) = sqrt((1 + cos) / 2)
+        Scalar length0 = std::sqrt(D0x * D0x + D0y * D0y);
+        Scalar length1 = std::sqrt(D1x * D1x + D1y * D1y);
+        Scalar u0x = D0x / length0, u0y = D0y / length0;
+        Scalar u1x = D1x / length1, u1y = D1y / length1;
+        Scalar cosAngle = u0x * u1x + u0y * u1y;
+        Scalar sinAngle = std::sqrt(1 - cosAngle * cosAngle);
+        Scalar tanHalf = sinAngle / (1 + cosAngle);
+        Scalar cosHalf = std::sqrt((1 + cosAngle) / 2);
+
+        Scalar bisectorX = u0x + u1x, bisectorY = u0y + u1y;
+        Scalar bisectorLength = std::sqrt(bisectorX * bisectorX + bisectorY * bisectorY);
+        Scalar centerDistance = d[i] / cosHalf / bisectorLength;
+
+        radius[i] = d[i] * tanHalf;
+        centerX[i] = intersectionX - centerDistance * bisectorX;
+        centerY[i] = intersectionY - centerDistance * bisectorY;
+        tan0X[i] = intersectionX - d[i] * u0x;
+        tan0Y[i] = intersectionY - d[i] * u0y;
+        tan1X[i] = intersectionX - d[i] * u1x;
+        tan1Y[i] = intersectionY - d[i] * u1y;
+    }
+}
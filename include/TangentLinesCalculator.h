@@ -1,107 +1,116 @@
 //* Author: Zac Zhuo Zhang
-//* Calculate the tangent line of two circles in 2D-XY space (Z = 0).
+//* Calculate the tangent line of two circles in 2D-XY space.
 //* Knowing that there are four tangent lines for two non-intersecting circles:
 //* getTangentLines0 calculates the two tangent lines that intersects.
 //* getTangentLines1 calculates the other two tangent lines that do not intersect.
+//* The Batch variants solve N circle pairs given as structure-of-arrays.
+//* They use the same geometry with the angles replaced by their cosines and sines (no trig calls, no branches),
+//* so the loops vectorize (AVX2/NEON) and only touch the caller's arrays.
+//* Templated on the scalar type: TangentLinesCalculator2D computes in double, TangentLinesCalculator2Df in float
+//* (twice the lanes per vector in the batch loops). Points and results are fixed-size 2D, on the stack.
+
+#pragma once
 
 #include <Eigen/Dense>
+#include <cmath>
 
-class TangentLinesCalculator2D
+//* N circle pairs (p0, r0) and (p1, r1) in the XY plane, as structure-of-arrays.
+template <typename Scalar>
+struct BasicCirclePairsSoA
 {
-public:
-    Eigen::MatrixXd getTangentLines0(const Eigen::Vector3d &p0, double r0, const Eigen::Vector3d &p1, double r1);
-    Eigen::MatrixXd getTangentLines1(const Eigen::Vector3d &p0, double r0, const Eigen::Vector3d &p1, double r1);
-    Eigen::Vector3d Transition2D(double _x, double _y, double _angle, int fx);
+    const Scalar *x0, *y0, *r0;
+    const Scalar *x1, *y1, *r1;
+    int count;
+};
+
+//* N x 4 tangent points, as structure-of-arrays: x[k][i], y[k][i] is row k of configuration i.
+template <typename Scalar>
+struct BasicTangentPointsSoA
+{
+    Scalar *x[4];
+    Scalar *y[4];
 };
 
-Eigen::MatrixXd TangentLinesCalculator2D::getTangentLines0(const Eigen::Vector3d &p0, double r0, const Eigen::Vector3d &p1, double r1)
+typedef BasicCirclePairsSoA<double> CirclePairsSoA;
+typedef BasicCirclePairsSoA<float> CirclePairsSoAf;
+typedef BasicTangentPointsSoA<double> TangentPointsSoA;
+typedef BasicTangentPointsSoA<float> TangentPointsSoAf;
+
+template <typename Scalar>
+class BasicTangentLinesCalculator2D
 {
-    Eigen::Vector3d r1LowPoint;
-    Eigen::Vector3d r0UpPoint;
-    Eigen::Vector3d r0LowPoint;
-    Eigen::Vector3d r1UpPoint;
+public:
+    typedef Eigen::Matrix<Scalar, 2, 1> Point;
+    //* Row k is tangent point k.
+    typedef Eigen::Matrix<Scalar, 4, 2> Points;
+
+    Points getTangentLines0(const Point &p0, Scalar r0, const Point &p1, Scalar r1) const;
+    Points getTangentLines1(const Point &p0, Scalar r0, const Point &p1, Scalar r1) const;
+    void getTangentLines0Batch(const BasicCirclePairsSoA<Scalar> &circles, const BasicTangentPointsSoA<Scalar> &points) const;
+    void getTangentLines1Batch(const BasicCirclePairsSoA<Scalar> &circles, const BasicTangentPointsSoA<Scalar> &points) const;
+    static Point Transition2D(Scalar _x, Scalar _y, Scalar _angle, int fx);
+};
 
-    double aa = std::atan2(p1.y() - p0.y(), p1.x() - p0.x());
-    double centerLine = (p1 - p0).norm();
-    double bb = std::acos((std::abs(r0 - r1)) / centerLine);
-    double cc = bb - aa;
+typedef BasicTangentLinesCalculator2D<double> TangentLinesCalculator2D;
+typedef BasicTangentLinesCalculator2D<float> TangentLinesCalculator2Df;
 
+template <typename Scalar>
+typename BasicTangentLinesCalculator2D<Scalar>::Points BasicTangentLinesCalculator2D<Scalar>::getTangentLines0(const Point &p0, Scalar r0, const Point &p1, Scalar r1) const
+{
+    Point r1LowPoint, r0UpPoint, r0LowPoint, r1UpPoint;
+
+    Scalar aa = std::atan2(p1.y() - p0.y(), p1.x() - p0.x());
+    Scalar centerLine = (p1 - p0).norm();
+    Scalar bb = std::acos((std::abs(r0 - r1)) / centerLine);
+    Scalar cc = bb - aa;
 
-    double r2LowX = r1 * std::cos(cc);
-    double r2LowY = r1 * std::sin(cc);
-    double r1UpX = r0 * std::cos(cc);
-    double r1UpY = r0 * std::sin(cc);
+    Scalar r2LowX = r1 * std::cos(cc);
+    Scalar r2LowY = r1 * std::sin(cc);
+    Scalar r1UpX = r0 * std::cos(cc);
+    Scalar r1UpY = r0 * std::sin(cc);
 
     r1LowPoint.x() = p1.x() - r2LowX;
     r1LowPoint.y() = p1.y() + r2LowY;
     r0UpPoint.x() = p0.x() + r1UpX;
     r0UpPoint.y() = p0.y() - r1UpY;
 
-    Eigen::Vector3d r2Tempoint = Transition2D(r1LowPoint.x() - p1.x(), r1LowPoint.y() - p1.y(), 2 * bb, 1);
-    r1UpPoint.x() = p1.x() + r2Tempoint.x();
-    r1UpPoint.y() = p1.y() + r2Tempoint.y();
-
-    Eigen::Vector3d r1Tempoint = Transition2D(r0UpPoint.x() - p0.x(), r0UpPoint.y() - p0.y(), 2 * bb, 1);
-    r0LowPoint.x() = p0.x() + r1Tempoint.x();
-    r0LowPoint.y() = p0.y() + r1Tempoint.y();
-
-    Eigen::MatrixXd Points(4, 3);
-    Points.row(0) = r0LowPoint;
-    Points.row(1) = r1LowPoint;
-    Points.row(2) = r0UpPoint;
-    Points.row(3) = r1UpPoint;
+    r1UpPoint = p1 + Transition2D(r1LowPoint.x() - p1.x(), r1LowPoint.y() - p1.y(), 2 * bb, 1);
+    r0LowPoint = p0 + Transition2D(r0UpPoint.x() - p0.x(), r0UpPoint.y() - p0.y(), 2 * bb, 1);
 
-    return Points;
+    Points points;
+    points.row(0) = r0LowPoint;
+    points.row(1) = r1LowPoint;
+    points.row(2) = r0UpPoint;
+    points.row(3) = r1UpPoint;
+    return points;
 }
 
-Eigen::MatrixXd TangentLinesCalculator2D::getTangentLines1(const Eigen::Vector3d &p0, double r0, const Eigen::Vector3d &p1, double r1)
+template <typename Scalar>
+typename BasicTangentLinesCalculator2D<Scalar>::Points BasicTangentLinesCalculator2D<Scalar>::getTangentLines1(const Point &p0, Scalar r0, const Point &p1, Scalar r1) const
 {
-    Eigen::Vector3d r1LowPoint;
-    Eigen::Vector3d r0UpPoint;
-    Eigen::Vector3d r0LowPoint;
-    Eigen::Vector3d r1UpPoint;
-
-
-    double centerLine = (p1 - p0).norm();
-    double radiusSum = r0 + r1;
-    double aa = std::atan2(p1.y() - p0.y(), p1.x() - p0.x());
-    double bb = std::acos(radiusSum / centerLine);
-
-    double r0UpX = r0 * std::cos(aa + bb);
-    double r0UpY = r0 * std::sin(aa + bb);
-    r0UpPoint.x() = p0.x() + r0UpX;
-    r0UpPoint.y() = p0.y() + r0UpY;
-
-    double r1LowX = r1 * std::cos(aa - bb);
-    double r1LowY = r1 * std::sin(aa - bb);
-    r1LowPoint.x() = p1.x() + r1LowX;
-    r1LowPoint.y() = p1.y() + r1LowY;
-
-
-    double r1UpX = r1 * std::cos(aa + bb);
-    double r1UpY = r1 * std::sin(aa + bb);
-    r1UpPoint.x() = p1.x() + r1UpX;
-    r1UpPoint.y() = p1.y() + r1UpY;
-
-    double r0LowX = r0 * std::cos(aa - bb);
-    double r0LowY = r0 * std::sin(aa - bb);
-    r0LowPoint.x() = p0.x() - r0LowX;
-    r0LowPoint.y() = p0.y() - r0LowY;
-
-    Eigen::MatrixXd Points(4, 3);
-    Points.row(0) = r0UpPoint;
-    Points.row(1) = r1LowPoint;
-    Points.row(2) = r1UpPoint;
-    Points.row(3) = r0LowPoint;
-
-    return Points;
-
+    Scalar centerLine = (p1 - p0).norm();
+    Scalar radiusSum = r0 + r1;
+    Scalar aa = std::atan2(p1.y() - p0.y(), p1.x() - p0.x());
+    Scalar bb = std::acos(radiusSum / centerLine);
+
+    Point r0UpPoint = p0 + r0 * Point(std::cos(aa + bb), std::sin(aa + bb));
+    Point r1LowPoint = p1 + r1 * Point(std::cos(aa - bb), std::sin(aa - bb));
+    Point r1UpPoint = p1 + r1 * Point(std::cos(aa + bb), std::sin(aa + bb));
+    Point r0LowPoint = p0 - r0 * Point(std::cos(aa - bb), std::sin(aa - bb));
+
+    Points points;
+    points.row(0) = r0UpPoint;
+    points.row(1) = r1LowPoint;
+    points.row(2) = r1UpPoint;
+    points.row(3) = r0LowPoint;
+    return points;
 }
 
-Eigen::Vector3d TangentLinesCalculator2D::Transition2D(double _x, double _y, double _angle, int fx)
+template <typename Scalar>
+typename BasicTangentLinesCalculator2D<Scalar>::Point BasicTangentLinesCalculator2D<Scalar>::Transition2D(Scalar _x, Scalar _y, Scalar _angle, int fx)
 {
-    double newX = 0;
-    double newY = 0;
+    Scalar newX = 0;
+    Scalar newY = 0;
 
     if (fx == 1)
     {
@@ -114,5 +123,85 @@ Eigen::Vector3d TangentLinesCalculator2D::Transition2D(double _x, double _y, dou
         newY = _y * std::cos(_angle) - _x * std::sin(_angle);
     }
 
-    return Eigen::Vector3d(newX, newY, 0);
+    return Point(newX, newY);
+}
+
+template <typename Scalar>
+void BasicTangentLinesCalculator2D<Scalar>::getTangentLines0Batch(const BasicCirclePairsSoA<Scalar> &circles, const BasicTangentPointsSoA<Scalar> &points) const
+{
+    const Scalar *__restrict x0 = circles.x0, *__restrict y0 = circles.y0, *__restrict r0 = circles.r0;
+    const Scalar *__restrict x1 = circles.x1, *__restrict y1 = circles.y1, *__restrict r1 = circles.r1;
+    Scalar *__restrict r0LowX = points.x[0], *__restrict r0LowY = points.y[0];
+    Scalar *__restrict r1LowX = points.x[1], *__restrict r1LowY = points.y[1];
+    Scalar *__restrict r0UpX = points.x[2], *__restrict r0UpY = points.y[2];
+    Scalar *__restrict r1UpX = points.x[3], *__restrict r1UpY = points.y[3];
+
+#pragma omp simd
+    for (int i = 0; i < circles.count; i++)
+    {
+        //* aa = atan2(dy, dx), bb = acos(|r0 - r1| / centerLine), cc = bb - aa
+        Scalar dx = x1[i] - x0[i];
+        Scalar dy = y1[i] - y0[i];
+        Scalar centerLine = std::sqrt(dx * dx + dy * dy);
+        Scalar cosA = dx / centerLine;
+        Scalar sinA = dy / centerLine;
+        Scalar cosB = std::abs(r0[i] - r1[i]) / centerLine;
+        Scalar sinB = std::sqrt(1 - cosB * cosB);
+        Scalar cosC = cosB * cosA + sinB * sinA;
+        Scalar sinC = sinB * cosA - cosB * sinA;
+
+        //* Rotation by 2 * bb
+        Scalar cos2B = 2 * cosB * cosB - 1;
+        Scalar sin2B = 2 * sinB * cosB;
+
+        Scalar r1LowDx = -r1[i] * cosC, r1LowDy = r1[i] * sinC;
+        Scalar r0UpDx = r0[i] * cosC, r0UpDy = -r0[i] * sinC;
+
+        r1LowX[i] = x1[i] + r1LowDx;
+        r1LowY[i] = y1[i] + r1LowDy;
+        r0UpX[i] = x0[i] + r0UpDx;
+        r0UpY[i] = y0[i] + r0UpDy;
+        r1UpX[i] = x1[i] + r1LowDx * cos2B - r1LowDy * sin2B;
+        r1UpY[i] = y1[i] + r1LowDx * sin2B + r1LowDy * cos2B;
+        r0LowX[i] = x0[i] + r0UpDx * cos2B - r0UpDy * sin2B;
+        r0LowY[i] = y0[i] + r0UpDx * sin2B + r0UpDy * cos2B;
+    }
+}
+
+template <typename Scalar>
+void BasicTangentLinesCalculator2D<Scalar>::getTangentLines1Batch(const BasicCirclePairsSoA<Scalar> &circles, const BasicTangentPointsSoA<Scalar> &points) const
+{
+    const Scalar *__restrict x0 = circles.x0, *__restrict y0 = circles.y0, *__restrict r0 = circles.r0;
+    const Scalar *__restrict x1 = circles.x1, *__restrict y1 = circles.y1, *__restrict r1 = circles.r1;
+    Scalar *__restrict r0UpX = points.x[0], *__restrict r0UpY = points.y[0];
+    Scalar *__restrict r1LowX = points.x[1], *__restrict r1LowY = points.y[1];
+    Scalar *__restrict r1UpX = points.x[2], *__restrict r1UpY = points.y[2];
+    Scalar *__restrict r0LowX = points.x[3], *__restrict r0LowY = points.y[3];
+
+#pragma omp simd
+    for (int i = 0; i < circles.count; i++)
+    {
+        //* aa = atan2(dy, dx), bb = acos((r0 + r1) / centerLine)
+        Scalar dx = x1[i] - x0[i];
+        Scalar dy = y1[i] - y0[i];
+        Scalar centerLine = std::sqrt(dx * dx + dy * dy);
+        Scalar cosA = dx / centerLine;
+        Scalar sinA = dy / centerLine;
+        Scalar cosB = (r0[i] + r1[i]) / centerLine;
+        Scalar sinB = std::sqrt(1 - cosB * cosB);
+
+        Scalar cosApB = cosA * cosB - sinA * sinB;
+        Scalar sinApB = sinA * cosB + cosA * sinB;
+        Scalar cosAmB = cosA * cosB + sinA * sinB;
+        Scalar sinAmB = sinA * cosB - cosA * sinB;
+
+        r0UpX[i] = x0[i] + r0[i] * cosApB;
+        r0UpY[i] = y0[i] + r0[i] * sinApB;
+        r1LowX[i] = x1[i] + r1[i] * cosAmB;
+        r1LowY[i] = y1[i] + r1[i] * sinAmB;
+        r1UpX[i] = x1[i] + r1[i] * cosApB;
+        r1UpY[i] = y1[i] + r1[i] * sinApB;
+        r0LowX[i] = x0[i] - r0[i] * cosAmB;
+        r0LowY[i] = y0[i] - r0[i] * sinAmB;
+    }
 }
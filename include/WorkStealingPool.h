@@ -0,0 +1,196 @@
+//* Author: Zac Zhuo Zhang
+//* A small work-stealing thread pool for the headless batch tools.
+//* Every worker owns a task deque: it pops its own newest task (LIFO),
+//* and when it runs dry it steals the oldest task of another worker (FIFO).
+//* parallelFor splits ranges recursively, so idle workers always steal the biggest remaining chunk.
+//* The thread that calls parallelFor helps executing tasks until its range is done.
+//* Tasks must not throw.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    unsigned threadCount() const { return workerCount; }
+
+    //* Index of the calling worker in [0, threadCount()), or threadCount() for any other thread.
+    //* Useful to pick a per-thread workspace inside parallelFor.
+    unsigned currentThreadIndex() const;
+
+    void submit(std::function<void()> task);
+
+    //* Call function(i) for every i in [begin, end), ranges smaller than grain are not split further.
+    template <typename Function>
+    void parallelFor(int begin, int end, int grain, Function function);
+
+private:
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool tryRunOne(unsigned home);
+    void workerLoop(unsigned index);
+
+    static unsigned resolveThreadCount(unsigned threadCount);
+
+    //* Fixed before any worker starts: workers read it, but never the workers vector itself.
+    const unsigned workerCount;
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<int> queuedTasks{0};
+    std::atomic<unsigned> nextQueue{0};
+    bool stopping = false;
+
+    static thread_local const WorkStealingPool *currentPool;
+    static thread_local unsigned currentIndex;
+};
+
+inline thread_local const WorkStealingPool *WorkStealingPool::currentPool = nullptr;
+inline thread_local unsigned WorkStealingPool::currentIndex = 0;
+
+inline unsigned WorkStealingPool::resolveThreadCount(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    return threadCount == 0 ? 1 : threadCount;
+}
+
+inline WorkStealingPool::WorkStealingPool(unsigned threadCount) : workerCount(resolveThreadCount(threadCount))
+{
+    for (unsigned i = 0; i < workerCount; i++)
+        queues.emplace_back(new TaskQueue());
+    workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; i++)
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+inline WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCondition.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+inline unsigned WorkStealingPool::currentThreadIndex() const
+{
+    return currentPool == this ? currentIndex : threadCount();
+}
+
+inline void WorkStealingPool::submit(std::function<void()> task)
+{
+    //* Workers push onto their own deque, other threads distribute round robin.
+    unsigned target = currentPool == this ? currentIndex : nextQueue++ % threadCount();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    queuedTasks++;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCondition.notify_one();
+}
+
+inline bool WorkStealingPool::tryRunOne(unsigned home)
+{
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(queues[home]->mutex);
+        if (!queues[home]->tasks.empty())
+        {
+            task = std::move(queues[home]->tasks.back());
+            queues[home]->tasks.pop_back();
+        }
+    }
+    for (unsigned k = 1; !task && k < threadCount(); k++)
+    {
+        TaskQueue &victim = *queues[(home + k) % threadCount()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task)
+        return false;
+
+    queuedTasks--;
+    task();
+    return true;
+}
+
+inline void WorkStealingPool::workerLoop(unsigned index)
+{
+    currentPool = this;
+    currentIndex = index;
+
+    while (true)
+    {
+        if (tryRunOne(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [this]
+                            { return stopping || queuedTasks.load() > 0; });
+        if (stopping)
+            return;
+    }
+}
+
+template <typename Function>
+void WorkStealingPool::parallelFor(int begin, int end, int grain, Function function)
+{
+    if (begin >= end)
+        return;
+    if (grain < 1)
+        grain = 1;
+
+    std::atomic<int> remaining(end - begin);
+    std::function<void(int, int)> runRange = [&](int low, int high)
+    {
+        //* Keep the lower half, hand out the upper half to be stolen.
+        while (high - low > grain)
+        {
+            int middle = low + (high - low) / 2;
+            submit([&runRange, middle, high]
+                   { runRange(middle, high); });
+            high = middle;
+        }
+        for (int i = low; i < high; i++)
+            function(i);
+        remaining -= high - low;
+    };
+    runRange(begin, end);
+
+    unsigned home = currentPool == this ? currentIndex : 0;
+    while (remaining.load() > 0)
+    {
+        if (!tryRunOne(home))
+            std::this_thread::yield();
+    }
+}
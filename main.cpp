@@ -1,181 +1,25 @@
 //* Author: Zac Zhuo Zhang
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
 #include <igl/readOFF.h>
 #include <igl/opengl/glfw/Viewer.h>
+#include <igl/project.h>
 
 #include <igl/opengl/glfw/imgui/ImGuiPlugin.h>
 #include <igl/opengl/glfw/imgui/ImGuiMenu.h>
 #include <igl/opengl/glfw/imgui/ImGuiHelpers.h>
 
-#include "TangentLinesCalculator.h"
-#include "TangentCircleCalculator.h"
-#include "DivideArc.h"
-
-Eigen::MatrixXd V;
-Eigen::MatrixXi F;
-
-TangentLinesCalculator2D tangentLinesCalculator;
-TangentCircleCalculator2D tangentCircleCalculator;
-CircleArcDivider2D circleArcDivider;
-
-std::pair<Eigen::MatrixXd, Eigen::MatrixXi> ArmMeshGeneration(double R0, double R1, double R2, double Rad0, double Rad1, double length0, double length1, double d, double MeshMaxDistance, double thickness)
-{
-
-    //* GEOMETRIC MATH----------------------------------------------------------------------------------------------------------------------------------------------------------------
-    Eigen::Vector3d P0(0, 0, 0);
-    Eigen::Vector3d P1(length0 * std::cos(Rad0), length0 * std::sin(Rad0), 0);
-    Eigen::Vector3d P2 = P1 + Eigen::Vector3d(std::cos(-Rad1) * length1, std::sin(-Rad1) * length1, 0);
-
-    Eigen::MatrixXd tan0Points = tangentLinesCalculator.getTangentLines0(P0, R0, P1, R1);
-
-    Eigen::MatrixXd tan1Points = tangentLinesCalculator.getTangentLines0(P1, R1, P2, R2);
-    // std::cout << tan1Points.size() << std::endl;
-
-    Eigen::MatrixXd arcPoints0 = circleArcDivider.divideArc2D(P0, R0, tan0Points.row(0), tan0Points.row(2), MeshMaxDistance);
-    Eigen::MatrixXd arcPoints1 = circleArcDivider.divideArc2D(P1, R1, tan1Points.row(0), tan0Points.row(1), MeshMaxDistance);
-
-    Eigen::MatrixXd tanPoints;
-    std::pair<Eigen::Vector3d, double> centerRadius = tangentCircleCalculator.getTangentCircleCenter(tan0Points.row(2), tan0Points.row(3), tan1Points.row(3), tan1Points.row(2), d, tanPoints);
-    Eigen::MatrixXd arcPoints2 = circleArcDivider.divideArc2D(centerRadius.first, centerRadius.second, tanPoints.row(1), tanPoints.row(0), MeshMaxDistance);
-
-    Eigen::MatrixXd arcPoints3 = circleArcDivider.divideArc2D(P2, R2, tan1Points.row(3), tan1Points.row(1), MeshMaxDistance);
-
-
-    // * CREATE MESH----------------------------------------------------------------------------------------------------------------------------------------------------------------
-    // *Vertices Collection
-    Eigen::MatrixXd P(2, 3);
-    P.row(0) = P0;
-    P.row(1) = P2;
-    int indexP0 = arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + arcPoints3.rows();
-    int indexP1 = arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + arcPoints3.rows() + 1;
-
-    Eigen::MatrixXd frontVertices(arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + arcPoints3.rows() + P.rows(), 3);
-    frontVertices << arcPoints0, arcPoints1, arcPoints2, arcPoints3, P;
-
-    Eigen::MatrixXd backVertices(frontVertices.rows(), 3);
-    for (int i = 0; i < backVertices.rows(); i++)
-    {
-        backVertices(i, 0) = frontVertices(i, 0);
-        backVertices(i, 1) = frontVertices(i, 1);
-        backVertices(i, 2) = -thickness;
-    }
-    Eigen::MatrixXd V(frontVertices.rows() + backVertices.rows(), 3);
-    V << frontVertices, backVertices;
-
-    // * Faces
-    // Section 0 with its side
-    Eigen::MatrixXi f0(arcPoints0.rows() - 1, 3);
-    Eigen::MatrixXi f0s((arcPoints0.rows() - 1) * 2, 3);
-
-    for (int i = 0; i < arcPoints0.rows() - 1; i++)
-    {
-        f0.row(i) = Eigen::Vector3i(i, i + 1, indexP0);
-        f0s.row(i) = Eigen::Vector3i(i, frontVertices.rows() + i, frontVertices.rows() + i + 1);
-        f0s.row(arcPoints0.rows() - 1 + i) = Eigen::Vector3i(i, frontVertices.rows() + i + 1, i + 1);
-    }
-
-    // Section 1 with its side
-    Eigen::MatrixXi f1(3, 3);
-    Eigen::MatrixXi f1s(4, 3);
-    f1.row(0) = Eigen::Vector3i(arcPoints0.rows() - 1, arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() - 1, indexP0);
-    f1.row(1) = Eigen::Vector3i(indexP0, arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() - 1, arcPoints0.rows() + arcPoints1.rows() - 1);
-    f1.row(2) = Eigen::Vector3i(indexP0, arcPoints0.rows() + arcPoints1.rows() - 1, 0);
-
-    f1s.row(0) = Eigen::Vector3i(arcPoints0.rows() - 1, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() - 1, arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() - 1);
-    f1s.row(1) = Eigen::Vector3i(arcPoints0.rows() - 1, frontVertices.rows() + arcPoints0.rows() - 1, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() - 1);
-    f1s.row(2) = Eigen::Vector3i(0, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() - 1, frontVertices.rows());
-    f1s.row(3) = Eigen::Vector3i(0, arcPoints0.rows() + arcPoints1.rows() - 1, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() - 1);
-
-    // Section 2 with its side
-    std::vector<Eigen::Vector3i> f2_vec;
-    for (int i = 1; i < std::max(arcPoints1.rows(), arcPoints2.rows()); i++)
-    {
-        if (i < arcPoints1.rows())
-            if (i < arcPoints2.rows())
-                f2_vec.push_back(Eigen::Vector3i(arcPoints0.rows() + i - 1, arcPoints0.rows() + i, arcPoints0.rows() + arcPoints1.rows() + i - 1));
-            else
-                f2_vec.push_back(Eigen::Vector3i(arcPoints0.rows() + i - 1, arcPoints0.rows() + i, arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() - 1));
-        if (i < arcPoints2.rows())
-            if (i < arcPoints1.rows())
-                f2_vec.push_back(Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows() + i, arcPoints0.rows() + arcPoints1.rows() + i - 1, arcPoints0.rows() + i));
-            else
-                f2_vec.push_back(Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows() + i, arcPoints0.rows() + arcPoints1.rows() + i - 1, arcPoints0.rows() + arcPoints1.rows() - 1));
-    }
-
-    Eigen::MatrixXi f2(f2_vec.size(), 3);
-    for (int i = 0; i < f2_vec.size(); ++i)
-        f2.row(i) = f2_vec[i];
-
-    Eigen::MatrixXi f2s0((arcPoints1.rows() - 1) * 2, 3);
-    for (int i = 0; i < arcPoints1.rows() - 1; i++)
-    {
-        f2s0.row(i) = Eigen::Vector3i(arcPoints0.rows() + i, frontVertices.rows() + arcPoints0.rows() + i, frontVertices.rows() + arcPoints0.rows() + i + 1);
-        f2s0.row(arcPoints1.rows() - 1 + i) = Eigen::Vector3i(arcPoints0.rows() + i, frontVertices.rows() + arcPoints0.rows() + i + 1, arcPoints0.rows() + i + 1);
-    }
-    Eigen::MatrixXi f2s1((arcPoints2.rows() - 1) * 2, 3);
-    for (int i = 0; i < arcPoints2.rows() - 1; i++)
-    {
-        f2s1.row(i) = Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows() + i, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + i + 1, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + i);
-        f2s1.row(arcPoints2.rows() - 1 + i) = Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows() + i, arcPoints0.rows() + arcPoints1.rows() + i + 1, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + i + 1);
-    }
-
-    // Section 3
-    Eigen::MatrixXi f3(3, 3);
-    Eigen::MatrixXi f3s(4, 3);
-
-    f3.row(0) = Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows(), arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows(), indexP1);
-    f3.row(1) = Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows(), indexP1, arcPoints0.rows());
-    f3.row(2) = Eigen::Vector3i(arcPoints0.rows(), indexP1, arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + arcPoints3.rows() - 1);
-
-    f3s.row(0) = Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows(), frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows(), frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows());
-    f3s.row(1) = Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows(), frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows(), arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows());
-    f3s.row(2) = Eigen::Vector3i(arcPoints0.rows(), frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + arcPoints3.rows() - 1, frontVertices.rows() + arcPoints0.rows());
-    f3s.row(3) = Eigen::Vector3i(arcPoints0.rows(), arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + arcPoints3.rows() - 1, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + arcPoints3.rows() - 1);
-
-    // Section4
-    Eigen::MatrixXi f4(arcPoints3.rows() - 1, 3);
-    Eigen::MatrixXi f4s((arcPoints3.rows() - 1) * 2, 3);
-    for (int i = 0; i < arcPoints3.rows() - 1; i++)
-    {
-        f4.row(i) = Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + i, arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + i + 1, indexP1);
-        f4s.row(i) = Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + i, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + i, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + i + 1);
-        f4s.row(arcPoints3.rows() - 1 + i) = Eigen::Vector3i(arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + i, frontVertices.rows() + arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + i + 1, arcPoints0.rows() + arcPoints1.rows() + arcPoints2.rows() + i + 1);
-    }
-
-    // Back
-    Eigen::MatrixXi frontFaces(f0.rows() + f1.rows() + f2.rows() + f3.rows() + f4.rows(), 3);
-    frontFaces << f0, f1, f2, f3, f4;
-    // std::cout << frontVertices.rows() << std::endl;
-    // std::cout << V.rows() << std::endl;
-    // std::cout << frontFaces.rows() << std::endl;
-    Eigen::MatrixXi backFaces(frontFaces.rows(), 3);
-    for (int i = 0; i < frontFaces.rows(); i++)
-    {
-        backFaces(i, 0) = frontFaces(i, 0) + frontVertices.rows();
-        backFaces(i, 1) = frontFaces(i, 2) + frontVertices.rows();
-        backFaces(i, 2) = frontFaces(i, 1) + frontVertices.rows();
-    }
-    // std::cout << backFaces << std::endl;
-
-    // Concatenate
-    Eigen::MatrixXi F(frontFaces.rows() + backFaces.rows() + f0s.rows() + f4s.rows() + f1s.rows() + f2s0.rows() + f2s1.rows() + f3s.rows(), 3);
-    F << frontFaces, backFaces, f0s, f4s, f1s, f2s0, f2s1, f3s;
-
-    return std::pair<Eigen::MatrixXd, Eigen::MatrixXi>(V, F);
-}
+#include "AsyncArmMesher.h"
+#include "ArmProfiler.h"
+#include "ArmTrajectory.h"
 
 int main(int argc, char *argv[])
 {
-    //* DEFAULT PARAMETERS (m) ----------------------------------------------------------------------------------------------------------------------------------------------------------------
-    double R0 = 0.300;
-    double R1 = 0.200;
-    double R2 = 0.200;
-    double Rad0 = M_PI / 6;
-    double Rad1 = -M_PI / 6;
-    double length0 = 1.200;
-    double length1 = 1.700;
-    double d = 0.200;
-    double MeshMaxDistance = 0.050; // The resolution of the mesh
-    double thickness = 0.50;
+    //* DEFAULT PARAMETERS (m), see ArmParameters.h ----------------------------------------------------------------------------------------------------------------------------------------------------------------
+    ArmParameters p;
 
     //* DISPLAY----------------------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -194,8 +38,106 @@ int main(int argc, char *argv[])
 
     igl::opengl::glfw::Viewer viewer;
 
-    std::pair<Eigen::MatrixXd, Eigen::MatrixXi> VF = ArmMeshGeneration(R0, R1, R2, Rad0, Rad1, length0, length1, d, MeshMaxDistance, thickness);
-    viewer.data().set_mesh(VF.first, VF.second);
+    //* Meshes are generated on a background thread; the viewer shows the last finished one.
+    AsyncArmMesher mesher(p);
+    viewer.data().set_mesh(mesher.current().V, mesher.current().F);
+    viewer.data().set_normals(mesher.current().N);
+
+    //* LEVEL OF DETAIL----------------------------------------------------------------------------------------------------------------------------------------------------------------
+    //* With autoLod, MeshMaxDistance follows the arm's size on screen instead of the slider.
+    bool autoLod = false;
+    int lodLevel = -1;
+
+    //* Screen pixels per model unit, from the projected bounding box of the shown mesh.
+    auto pixelsPerUnit = [&]()
+    {
+        const Eigen::MatrixXd &V = mesher.current().V;
+        Eigen::Vector3d min = V.colwise().minCoeff(), max = V.colwise().maxCoeff();
+        Eigen::Vector2f low = Eigen::Vector2f::Constant(std::numeric_limits<float>::max()), high = -low;
+        for (int c = 0; c < 8; c++)
+        {
+            Eigen::Vector3f corner((c & 1) ? max.x() : min.x(), (c & 2) ? max.y() : min.y(), (c & 4) ? max.z() : min.z());
+            Eigen::Vector3f screen = igl::project(corner, viewer.core().view, viewer.core().proj, viewer.core().viewport);
+            low = low.cwiseMin(screen.head<2>());
+            high = high.cwiseMax(screen.head<2>());
+        }
+        return (double)(high - low).norm() / (max - min).norm();
+    };
+
+    //* PLAYBACK----------------------------------------------------------------------------------------------------------------------------------------------------------------
+    //* A trajectory baked by arm_bake, given as the first argument, plays back with vertex-only uploads.
+    ArmTrajectoryReader playback;
+    bool showPlayback = argc > 1 && playback.open(argv[1]);
+    if (argc > 1 && !showPlayback)
+        std::cerr << "Cannot read baked trajectory: " << argv[1] << std::endl;
+    bool playing = showPlayback;
+    int playbackFrame = -1; // frame on screen, -1 while the generated mesh is shown
+    double playbackTime = 0;
+    Eigen::MatrixXd playbackV;
+    auto lastDraw = std::chrono::steady_clock::now();
+
+    viewer.callback_pre_draw = [&](igl::opengl::glfw::Viewer &)
+    {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - lastDraw).count();
+        lastDraw = now;
+        if (showPlayback)
+        {
+            if (playing)
+                playbackTime = std::fmod(playbackTime + elapsed, playback.frames() / playback.fps());
+            int frame = std::min((int)(playbackTime * playback.fps()), playback.frames() - 1);
+            if (frame != playbackFrame && playback.readFrame(frame, playbackV))
+            {
+                ARM_PROFILE_SCOPE(ArmStage::Upload);
+                if (playbackFrame < 0)
+                {
+                    viewer.data().clear();
+                    viewer.data().set_mesh(playbackV, playback.F());
+                }
+                else
+                {
+                    //* One index buffer for every frame: upload the positions only.
+                    viewer.data().set_vertices(playbackV);
+                }
+                viewer.data().compute_normals();
+                playbackFrame = frame;
+            }
+            viewer.core().is_animating = playing;
+            return false;
+        }
+
+        if (autoLod)
+        {
+            int level = mesher.lods().selectLevel(pixelsPerUnit());
+            if (level != lodLevel)
+            {
+                lodLevel = level;
+                mesher.request(p, lodLevel);
+            }
+        }
+
+        bool topologyChanged = false;
+        if (mesher.poll(topologyChanged))
+        {
+            ARM_PROFILE_SCOPE(ArmStage::Upload);
+            if (topologyChanged)
+            {
+                viewer.data().clear();
+                viewer.data().set_mesh(mesher.current().V, mesher.current().F);
+            }
+            else
+            {
+                //* Same faces: upload the positions only.
+                viewer.data().set_vertices(mesher.current().V);
+            }
+            //* Analytic normals from the generator, no recomputation over the mesh.
+            viewer.data().set_normals(mesher.current().N);
+        }
+        ARM_PROFILE_COMMIT((int)mesher.current().V.rows(), (int)mesher.current().F.rows());
+        //* Keep drawing frames while a mesh is pending, so it shows up without waiting for input.
+        viewer.core().is_animating = mesher.busy();
+        return false;
+    };
 
     igl::opengl::glfw::imgui::ImGuiPlugin plugin;
     viewer.plugins.push_back(&plugin);
@@ -208,25 +150,104 @@ int main(int argc, char *argv[])
         ImGui::SetNextWindowSize(ImVec2(250, 400), ImGuiCond_FirstUseEver);
         ImGui::Begin("The Arm", nullptr, ImGuiWindowFlags_NoSavedSettings);
         ImGui::PushItemWidth(-80);
-        if (
-            ImGui::DragScalar("R0", ImGuiDataType_Double, &R0, 0.1, &Rmin, &Rmax, "%.4f", (0.01F)) ||
-            ImGui::DragScalar("R1", ImGuiDataType_Double, &R1, 0.1, &Rmin, &Rmax, "%.4f", (0.01F)) ||
-            ImGui::DragScalar("R2", ImGuiDataType_Double, &R2, 0.1, &Rmin, &Rmax, "%.4f", (0.01F)) ||
-            ImGui::DragScalar("Rad0", ImGuiDataType_Double, &Rad0, 0.1, &Radmin, &Radmax, "%.4f", (0.01F)) ||
-            ImGui::DragScalar("Rad1", ImGuiDataType_Double, &Rad1, 0.1, &Radmin, &Radmax, "%.4f", (0.01F)) ||
-            ImGui::DragScalar("length0", ImGuiDataType_Double, &length0, 0.1, &lengthmin, &lengthmax, "%.4f", (0.01F)) ||
-            ImGui::DragScalar("length1", ImGuiDataType_Double, &length1, 0.1, &lengthmin, &lengthmax, "%.4f", (0.01F)) ||
-            ImGui::DragScalar("d", ImGuiDataType_Double, &d, 0.1, &dmin, &dmax, "%.4f", (0.01F)) ||
-            ImGui::DragScalar("MeshMaxDistance", ImGuiDataType_Double, &MeshMaxDistance, 0.1, &MeshMaxDistancemin, &MeshMaxDistancemax, "%.4f", (0.01F)) ||
-            ImGui::DragScalar("thickness", ImGuiDataType_Double, &thickness, 0.1, &thicknessmin, &thicknessmax, "%.4f", (0.01F)))
+        //* Draw every slider each frame, then update once.
+        bool changed = false;
+        changed |= ImGui::DragScalar("R0", ImGuiDataType_Double, &p.R0, 0.1, &Rmin, &Rmax, "%.4f", (0.01F));
+        changed |= ImGui::DragScalar("R1", ImGuiDataType_Double, &p.R1, 0.1, &Rmin, &Rmax, "%.4f", (0.01F));
+        changed |= ImGui::DragScalar("R2", ImGuiDataType_Double, &p.R2, 0.1, &Rmin, &Rmax, "%.4f", (0.01F));
+        changed |= ImGui::DragScalar("Rad0", ImGuiDataType_Double, &p.Rad0, 0.1, &Radmin, &Radmax, "%.4f", (0.01F));
+        changed |= ImGui::DragScalar("Rad1", ImGuiDataType_Double, &p.Rad1, 0.1, &Radmin, &Radmax, "%.4f", (0.01F));
+        changed |= ImGui::DragScalar("length0", ImGuiDataType_Double, &p.length0, 0.1, &lengthmin, &lengthmax, "%.4f", (0.01F));
+        changed |= ImGui::DragScalar("length1", ImGuiDataType_Double, &p.length1, 0.1, &lengthmin, &lengthmax, "%.4f", (0.01F));
+        changed |= ImGui::DragScalar("d", ImGuiDataType_Double, &p.d, 0.1, &dmin, &dmax, "%.4f", (0.01F));
+        changed |= ImGui::DragScalar("MeshMaxDistance", ImGuiDataType_Double, &p.MeshMaxDistance, 0.1, &MeshMaxDistancemin, &MeshMaxDistancemax, "%.4f", (0.01F));
+        changed |= ImGui::DragScalar("thickness", ImGuiDataType_Double, &p.thickness, 0.1, &thicknessmin, &thicknessmax, "%.4f", (0.01F));
+
+        if (ImGui::Checkbox("Auto LOD", &autoLod))
         {
-            viewer.data().clear();
-            std::pair<Eigen::MatrixXd, Eigen::MatrixXi> VF = ArmMeshGeneration(R0, R1, R2, Rad0, Rad1, length0, length1, d, MeshMaxDistance, thickness);
-            viewer.data().set_mesh(VF.first, VF.second);
+            //* Back to the slider's MeshMaxDistance, or let the next frame pick a level.
+            lodLevel = -1;
+            if (!autoLod)
+                changed = true;
         }
+        if (autoLod && lodLevel >= 0)
+            ImGui::Text("LOD %d, MeshMaxDistance %.5f", lodLevel, mesher.lods().meshMaxDistance(lodLevel));
+
+        if (changed)
+            mesher.request(p, autoLod ? lodLevel : -1);
+        if (mesher.busy())
+            ImGui::TextDisabled("Generating...");
+        ArmMeshCache::Statistics cache = mesher.cacheStatistics();
+        ImGui::TextDisabled("Mesh cache: %llu hits, %llu misses, %.1f MB", cache.hits, cache.misses, cache.bytes / 1048576.0);
 
         ImGui::PopItemWidth();
         ImGui::End();
+
+        if (playback.frames() > 0)
+        {
+            ImGui::SetNextWindowPos(ImVec2(180.f * menu.menu_scaling(), 420), ImGuiCond_FirstUseEver);
+            ImGui::SetNextWindowSize(ImVec2(250, 110), ImGuiCond_FirstUseEver);
+            ImGui::Begin("Playback", nullptr, ImGuiWindowFlags_NoSavedSettings);
+            if (ImGui::Checkbox("Show baked", &showPlayback) && !showPlayback)
+            {
+                //* Back to the generated mesh.
+                playbackFrame = -1;
+                viewer.data().clear();
+                viewer.data().set_mesh(mesher.current().V, mesher.current().F);
+                viewer.data().set_normals(mesher.current().N);
+            }
+            ImGui::Checkbox("Play", &playing);
+            int frame = std::max(playbackFrame, 0);
+            if (ImGui::SliderInt("frame", &frame, 0, playback.frames() - 1))
+            {
+                playing = false;
+                playbackTime = frame / playback.fps();
+            }
+            ImGui::Text("%d vertices, %.1f fps%s", playback.vertices(), playback.fps(), playback.delta() ? ", delta" : "");
+            ImGui::End();
+        }
+
+#ifdef ARM_PROFILING
+        //* Rolling p50/p99 over the last ArmProfiler::window samples of every stage.
+        ImGui::SetNextWindowPos(ImVec2(180.f * menu.menu_scaling() + 260, 10), ImGuiCond_FirstUseEver);
+        ImGui::SetNextWindowSize(ImVec2(330, 190), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Arm Timings", nullptr, ImGuiWindowFlags_NoSavedSettings);
+        ArmProfiler &profiler = ArmProfiler::instance();
+        ImGui::Text("%d vertices, %d faces", profiler.lastVertices(), profiler.lastFaces());
+        ImGui::Columns(3);
+        ImGui::Text("stage");
+        ImGui::NextColumn();
+        ImGui::Text("p50 (ms)");
+        ImGui::NextColumn();
+        ImGui::Text("p99 (ms)");
+        ImGui::NextColumn();
+        for (int k = 0; k < (int)ArmStage::Count; k++)
+        {
+            ArmProfiler::Statistics statistics = profiler.statistics((ArmStage)k);
+            ImGui::Text("%s", ArmProfiler::stageName((ArmStage)k));
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", statistics.p50);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", statistics.p99);
+            ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+        //* Full samples are only kept while recording.
+        if (!profiler.capturing())
+        {
+            if (ImGui::Button("Record CSV"))
+                profiler.setCapture(true);
+        }
+        else if (ImGui::Button("Save CSV"))
+        {
+            profiler.setCapture(false);
+            profiler.writeCsv("arm_timings.csv");
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Reset"))
+            profiler.clear();
+        ImGui::End();
+#endif
     };
 
     // *Launch
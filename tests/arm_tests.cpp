@@ -0,0 +1,362 @@
+//* Author: Zac Zhuo Zhang
+//* Self-checking regression tests of the mesh generation, run by ctest (arm_tests).
+//* Every check compares two ways of producing the same mesh:
+//*   the builder against the original ArmMeshGeneration (reproduced below as the baseline),
+//*   incremental ArmModel updates against fresh builds, stream() against build(),
+//*   the parallel ArmChainBuilder against the serial one, and baked trajectories against the builder.
+//* Prints every failed check and exits with 1 if there was any.
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "ArmParameters.h"
+#include "ArmMeshBuilder.h"
+#include "ArmModel.h"
+#include "ArmChainBuilder.h"
+#include "ArmTrajectory.h"
+#include "WorkStealingPool.h"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string &what)
+{
+    if (!condition)
+    {
+        std::printf("FAILED: %s\n", what.c_str());
+        failures++;
+    }
+}
+
+static double maxDifference(const Eigen::MatrixXd &A, const Eigen::MatrixXd &B)
+{
+    if (A.rows() != B.rows() || A.cols() != B.cols())
+        return INFINITY;
+    return A.rows() > 0 ? (A - B).cwiseAbs().maxCoeff() : 0;
+}
+
+static bool sameFaces(const Eigen::MatrixXi &A, const Eigen::MatrixXi &B)
+{
+    return A.rows() == B.rows() && A.cols() == B.cols() && A == B;
+}
+
+//* A few configurations around the viewer's defaults: resolutions, bent and stretched links, a thick arm.
+static std::vector<ArmParameters> testParameters()
+{
+    std::vector<ArmParameters> list;
+    for (double distance : {0.1, 0.05, 0.01, 0.002})
+    {
+        ArmParameters p;
+        p.MeshMaxDistance = distance;
+        list.push_back(p);
+
+        p.Rad0 = 1.2;
+        p.Rad1 = 0.2;
+        list.push_back(p);
+
+        p.R0 = 0.5;
+        p.R2 = 0.1;
+        p.length1 = 2.5;
+        p.d = 0.05;
+        p.thickness = 1.5;
+        list.push_back(p);
+    }
+    return list;
+}
+
+//* BASELINE----------------------------------------------------------------------------------------------------------------------------------------------------------------
+//* The original ArmMeshGeneration: every arc divided with exact cos/sin into its own block, faces section by
+//* section, then [front | back | sides f0s, f4s, f1s, f2s0, f2s1, f3s].
+static std::pair<Eigen::MatrixXd, Eigen::MatrixXi> baselineArmMesh(const ArmParameters &p)
+{
+    typedef Eigen::Vector2d Point;
+    TangentLinesCalculator2D tangentLinesCalculator;
+    TangentCircleCalculator2D tangentCircleCalculator;
+    CircleArcDivider2D circleArcDivider(ArcTessellation::Exact);
+
+    Point P0(0, 0);
+    Point P1(p.length0 * std::cos(p.Rad0), p.length0 * std::sin(p.Rad0));
+    Point P2 = P1 + Point(std::cos(-p.Rad1) * p.length1, std::sin(-p.Rad1) * p.length1);
+
+    TangentLinesCalculator2D::Points tan0Points = tangentLinesCalculator.getTangentLines0(P0, p.R0, P1, p.R1);
+    TangentLinesCalculator2D::Points tan1Points = tangentLinesCalculator.getTangentLines0(P1, p.R1, P2, p.R2);
+    TangentCircleCalculator2D::Points tanPoints;
+    std::pair<Point, double> centerRadius = tangentCircleCalculator.getTangentCircleCenter(tan0Points.row(2), tan0Points.row(3), tan1Points.row(3), tan1Points.row(2), p.d, tanPoints);
+
+    auto divide = [&](const Point &center, double radius, const Point &a, const Point &b)
+    {
+        Eigen::MatrixXd points(circleArcDivider.countArcPoints(center, radius, a, b, p.MeshMaxDistance), 3);
+        circleArcDivider.divideArc2D(center, radius, a, b, p.MeshMaxDistance, points);
+        return points;
+    };
+    Eigen::MatrixXd arc0 = divide(P0, p.R0, tan0Points.row(0), tan0Points.row(2));
+    Eigen::MatrixXd arc1 = divide(P1, p.R1, tan1Points.row(0), tan0Points.row(1));
+    Eigen::MatrixXd arc2 = divide(centerRadius.first, centerRadius.second, tanPoints.row(1), tanPoints.row(0));
+    Eigen::MatrixXd arc3 = divide(P2, p.R2, tan1Points.row(3), tan1Points.row(1));
+
+    const int n0 = (int)arc0.rows(), n1 = (int)arc1.rows(), n2 = (int)arc2.rows(), n3 = (int)arc3.rows();
+    const int indexP0 = n0 + n1 + n2 + n3, indexP2 = indexP0 + 1, nf = indexP0 + 2;
+
+    Eigen::MatrixXd V(2 * nf, 3);
+    V << arc0, arc1, arc2, arc3, Eigen::RowVector3d(P0.x(), P0.y(), 0), Eigen::RowVector3d(P2.x(), P2.y(), 0),
+        arc0, arc1, arc2, arc3, Eigen::RowVector3d(P0.x(), P0.y(), 0), Eigen::RowVector3d(P2.x(), P2.y(), 0);
+    V.bottomRows(nf).col(2).setConstant(-p.thickness);
+
+    typedef std::vector<Eigen::RowVector3i> Faces;
+    Faces f0, f0s, f1, f1s, f2, f2s0, f2s1, f3, f3s, f4, f4s;
+    f0s.resize(2 * (n0 - 1));
+    for (int i = 0; i < n0 - 1; i++)
+    {
+        f0.push_back({i, i + 1, indexP0});
+        f0s[i] = {i, nf + i, nf + i + 1};
+        f0s[n0 - 1 + i] = {i, nf + i + 1, i + 1};
+    }
+
+    f1.push_back({n0 - 1, n0 + n1 + n2 - 1, indexP0});
+    f1.push_back({indexP0, n0 + n1 + n2 - 1, n0 + n1 - 1});
+    f1.push_back({indexP0, n0 + n1 - 1, 0});
+    f1s.push_back({n0 - 1, nf + n0 + n1 + n2 - 1, n0 + n1 + n2 - 1});
+    f1s.push_back({n0 - 1, nf + n0 - 1, nf + n0 + n1 + n2 - 1});
+    f1s.push_back({0, nf + n0 + n1 - 1, nf});
+    f1s.push_back({0, n0 + n1 - 1, nf + n0 + n1 - 1});
+
+    for (int i = 1; i < std::max(n1, n2); i++)
+    {
+        if (i < n1)
+            f2.push_back({n0 + i - 1, n0 + i, i < n2 ? n0 + n1 + i - 1 : n0 + n1 + n2 - 1});
+        if (i < n2)
+            f2.push_back({n0 + n1 + i, n0 + n1 + i - 1, i < n1 ? n0 + i : n0 + n1 - 1});
+    }
+    f2s0.resize(2 * (n1 - 1));
+    for (int i = 0; i < n1 - 1; i++)
+    {
+        f2s0[i] = {n0 + i, nf + n0 + i, nf + n0 + i + 1};
+        f2s0[n1 - 1 + i] = {n0 + i, nf + n0 + i + 1, n0 + i + 1};
+    }
+    f2s1.resize(2 * (n2 - 1));
+    for (int i = 0; i < n2 - 1; i++)
+    {
+        f2s1[i] = {n0 + n1 + i, nf + n0 + n1 + i + 1, nf + n0 + n1 + i};
+        f2s1[n2 - 1 + i] = {n0 + n1 + i, n0 + n1 + i + 1, nf + n0 + n1 + i + 1};
+    }
+
+    f3.push_back({n0 + n1, n0 + n1 + n2, indexP2});
+    f3.push_back({n0 + n1, indexP2, n0});
+    f3.push_back({n0, indexP2, indexP0 - 1});
+    f3s.push_back({n0 + n1, nf + n0 + n1, nf + n0 + n1 + n2});
+    f3s.push_back({n0 + n1, nf + n0 + n1 + n2, n0 + n1 + n2});
+    f3s.push_back({n0, nf + indexP0 - 1, nf + n0});
+    f3s.push_back({n0, indexP0 - 1, nf + indexP0 - 1});
+
+    const int first3 = n0 + n1 + n2;
+    f4s.resize(2 * (n3 - 1));
+    for (int i = 0; i < n3 - 1; i++)
+    {
+        f4.push_back({first3 + i, first3 + i + 1, indexP2});
+        f4s[i] = {first3 + i, nf + first3 + i, nf + first3 + i + 1};
+        f4s[n3 - 1 + i] = {first3 + i, nf + first3 + i + 1, first3 + i + 1};
+    }
+
+    Faces front;
+    for (const Faces *section : {&f0, &f1, &f2, &f3, &f4})
+        front.insert(front.end(), section->begin(), section->end());
+    Faces all = front;
+    for (const Eigen::RowVector3i &f : front)
+        all.push_back({f(0) + nf, f(2) + nf, f(1) + nf});
+    for (const Faces *section : {&f0s, &f4s, &f1s, &f2s0, &f2s1, &f3s})
+        all.insert(all.end(), section->begin(), section->end());
+
+    Eigen::MatrixXi F((int)all.size(), 3);
+    for (int i = 0; i < (int)all.size(); i++)
+        F.row(i) = all[i];
+    return std::make_pair(V, F);
+}
+
+//* TESTS----------------------------------------------------------------------------------------------------------------------------------------------------------------
+//* Same faces; vertices up to the recurrence tessellation's rounding (see DivideArc.h).
+static void testBuilderMatchesBaseline()
+{
+    ArmMeshBuilder builder;
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi F;
+    for (const ArmParameters &p : testParameters())
+    {
+        std::pair<Eigen::MatrixXd, Eigen::MatrixXi> baseline = baselineArmMesh(p);
+        builder.build(p, V, F);
+        check(sameFaces(F, baseline.second), "builder faces == baseline faces");
+        check(maxDifference(V, baseline.first) < 1e-12, "builder vertices == baseline vertices");
+    }
+}
+
+//* Every parameter moved in turn, the model updating incrementally, against a fresh builder.
+static void testModelMatchesFreshBuild()
+{
+    for (bool normals : {false, true})
+    {
+        ArmModel model(ArmParameters(), normals);
+        model.update();
+        ArmParameters p;
+        for (int step = 0; step < 3; step++)
+            for (int k = 0; k < ArmParameters::Count; k++)
+            {
+                //* Small relative moves, so both topology changes (MeshMaxDistance, radii) and vertex-only updates occur.
+                p[k] *= step == 1 ? 0.9 : 1.07;
+                model.set(k, p[k]);
+                model.update();
+
+                ArmMeshBuilder builder(normals);
+                Eigen::MatrixXd V, N;
+                Eigen::MatrixXi F;
+                if (normals)
+                    builder.build(p, V, F, N);
+                else
+                    builder.build(p, V, F);
+                std::string what = std::string("ArmModel::update == fresh build after ") + ArmParameters::name(k);
+                check(sameFaces(model.F(), F), what + " (faces)");
+                check(maxDifference(model.V(), V) == 0, what + " (vertices)");
+                if (normals)
+                    check(maxDifference(model.N(), N) == 0, what + " (normals)");
+            }
+    }
+}
+
+//* Collects what a sink receives.
+class RecordingSink : public ArmMeshSink
+{
+public:
+    std::vector<double> vertices;
+    std::vector<int> faces;
+    bool faceCornersMatch = true;
+
+    void begin(int vertexCount, int faceCount) override
+    {
+        vertices.reserve(3 * vertexCount);
+        faces.reserve(3 * faceCount);
+    }
+    void vertex(double x, double y, double z) override
+    {
+        vertices.insert(vertices.end(), {x, y, z});
+    }
+    void face(int a, int b, int c, const Eigen::Vector3d &pa, const Eigen::Vector3d &pb, const Eigen::Vector3d &pc) override
+    {
+        faces.insert(faces.end(), {a, b, c});
+        faceCornersMatch = faceCornersMatch && corner(a) == pa && corner(b) == pb && corner(c) == pc;
+    }
+    bool end() override { return true; }
+
+private:
+    Eigen::Vector3d corner(int i) const { return Eigen::Vector3d(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2]); }
+};
+
+static void testStreamMatchesBuild()
+{
+    for (bool splitSides : {false, true})
+    {
+        ArmMeshBuilder builder(splitSides);
+        Eigen::MatrixXd V;
+        Eigen::MatrixXi F;
+        for (const ArmParameters &p : testParameters())
+        {
+            builder.build(p, V, F);
+            RecordingSink sink;
+            builder.stream(p, sink);
+
+            Eigen::MatrixXd streamedV = Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>>(sink.vertices.data(), sink.vertices.size() / 3, 3);
+            Eigen::MatrixXi streamedF = Eigen::Map<Eigen::Matrix<int, Eigen::Dynamic, 3, Eigen::RowMajor>>(sink.faces.data(), sink.faces.size() / 3, 3);
+            check(sameFaces(streamedF, F), "stream() faces == build() faces");
+            check(maxDifference(streamedV, V) == 0, "stream() vertices == build() vertices");
+            check(sink.faceCornersMatch, "stream() face corners == streamed vertices");
+        }
+    }
+}
+
+//* Enough links for several parallel tasks per pass.
+static void testParallelChainMatchesSerial()
+{
+    ArmChainParameters p;
+    const int links = 1000;
+    for (int j = 0; j < links; j++)
+    {
+        p.length.push_back(0.5 + 0.1 * (j % 3));
+        p.angle.push_back(j == 0 ? 0.2 : 0.1 + 0.05 * (j % 5));
+    }
+    for (int j = 0; j <= links; j++)
+        p.radius.push_back(0.1 + 0.02 * (j % 4));
+    p.MeshMaxDistance = 0.01;
+
+    WorkStealingPool pool(4);
+    ArmChainBuilder serial, parallel(&pool);
+    parallel.grain = 16;
+    Eigen::MatrixXd V0, V1;
+    Eigen::MatrixXi F0, F1;
+    check(serial.build(p, V0, F0) && parallel.build(p, V1, F1), "chain build succeeds");
+    check(sameFaces(F0, F1), "parallel chain faces == serial chain faces");
+    check(maxDifference(V0, V1) == 0, "parallel chain vertices == serial chain vertices");
+}
+
+//* Every frame read back equals the builder's mesh of that frame at the bake's common layout, in float.
+static void testBakeReadRoundTrip()
+{
+    ArmTrajectory trajectory;
+    trajectory.base.MeshMaxDistance = 0.02;
+    trajectory.keyframes = {{0, 0.3, 0.3}, {1, 1.2, 0.8}, {2, 0.5, -0.2}};
+    const int frames = 40;
+    const double fps = 20;
+
+    WorkStealingPool pool(2);
+    for (bool delta : {false, true})
+    {
+        const std::string path = std::string("arm_tests_") + (delta ? "delta" : "plain") + ".armtraj";
+        ArmTrajectoryBaker baker(&pool);
+        baker.chunkFrames = 16;
+        check(baker.bake(trajectory, frames, fps, path, delta), "bake succeeds");
+
+        ArmTrajectoryReader reader;
+        check(reader.open(path), "baked file opens");
+        check(reader.frames() == frames && reader.vertices() == baker.layout().vertices && reader.delta() == delta, "baked header");
+
+        ArmMeshBuilder builder;
+        Eigen::MatrixXi F(baker.layout().faces, 3);
+        Eigen::MatrixXd V(baker.layout().vertices, 3), frame;
+        const int *arcPoints = baker.layout().arcPoints;
+        for (int f = 0; f < frames && reader.vertices() == V.rows(); f++)
+        {
+            ArmParameters p = trajectory.at(trajectory.keyframes.front().time + f / fps);
+            builder.prepare(p, arcPoints);
+            builder.writeFrontVertices(V);
+            builder.writeBackVertices(V, p.thickness);
+            if (f == 0)
+            {
+                builder.writeFaces(F);
+                check(sameFaces(reader.F(), F), "baked faces == builder faces");
+            }
+            check(reader.readFrame(f, frame), "frame reads");
+            //* Plain frames hold the float positions, delta frames accumulate float differences.
+            double error = maxDifference(frame, V.cast<float>().cast<double>());
+            check(delta ? error < 1e-5 : error == 0, "read frame == builder frame" + std::string(delta ? " (delta)" : ""));
+        }
+        reader.close();
+        std::remove(path.c_str());
+    }
+}
+
+int main()
+{
+    testBuilderMatchesBaseline();
+    testModelMatchesFreshBuild();
+    testStreamMatchesBuild();
+    testParallelChainMatchesSerial();
+    testBakeReadRoundTrip();
+
+    if (failures > 0)
+    {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}